@@ -20,6 +20,9 @@
 #include <algorithm>
 #include <string.h>
 #include <cstdint>
+#ifdef WIN64
+#include <intrin.h>
+#endif
 
 /** All alphanumeric characters except for "0", "I", "O", and "l" */
 static const char* pszBase58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
@@ -128,6 +131,121 @@ std::string EncodeBase58(const std::vector<unsigned char>& vch)
     return EncodeBase58(vch.data(), vch.data() + vch.size());
 }
 
+// ----------------------------------------------------------------------------
+
+// 25 bytes payloads: 200 bits number in 4 limbs of 64 bits, divided by 58^10
+// 4 times (chunks of 10 digits, 40 >= 35 digits), the chunks are split in
+// 2 x 5 digits (58^5 < 2^32) for the last divisions.
+// The 128/64 bits divisions by 58^10 are multiplications by a precomputed
+// reciprocal (Moller-Granlund, divisor normalized by 2^5) instead of divq.
+#define B58_5  656356768ULL
+#define B58_10 430804206899405824ULL
+#define B58_10_SHIFT 5
+#define B58_10_NORM 0xBF50C498FF748000ULL  // 58^10 << 5
+#define B58_10_INV 0x568DF8B76CBF212CULL   // (2^128-1) / B58_10_NORM - 2^64
+
+static inline uint64_t Mul128(uint64_t a, uint64_t b, uint64_t *hi) {
+#ifdef WIN64
+  return _umul128(a, b, hi);
+#else
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *hi = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+#endif
+}
+
+// (hi:lo) / 58^10, hi < 58^10
+static inline uint64_t Div58_10(uint64_t hi, uint64_t lo, uint64_t *r) {
+
+  // Normalized dividend, u1 < B58_10_NORM
+  uint64_t u1 = (hi << B58_10_SHIFT) | (lo >> (64 - B58_10_SHIFT));
+  uint64_t u0 = lo << B58_10_SHIFT;
+
+  // Quotient estimate, off by at most one
+  uint64_t q1;
+  uint64_t q0 = Mul128(B58_10_INV, u1, &q1);
+  q0 += u0;
+  q1 += u1 + 1 + (q0 < u0);
+  uint64_t rn = u0 - q1 * B58_10_NORM;
+  if (rn > q0) {
+    q1--;
+    rn += B58_10_NORM;
+  }
+  if (rn >= B58_10_NORM) {
+    q1++;
+    rn -= B58_10_NORM;
+  }
+
+  *r = rn >> B58_10_SHIFT;
+  return q1;
+
+}
+
+static inline uint64_t LoadBE64(const unsigned char *p) {
+  uint64_t r = 0;
+  for (int i = 0; i < 8; i++)
+    r = (r << 8) | p[i];
+  return r;
+}
+
+// Chunks of a payload (least significant first)
+static void Chunks58(const unsigned char *in, uint64_t *chunk) {
+
+  uint64_t l[3];
+  uint64_t r = in[0];
+  for (int i = 0; i < 3; i++)
+    l[i] = LoadBE64(in + 1 + 8 * i);
+
+  for (int k = 0; k < 4; k++) {
+    // Long division from the most significant limb, the remainder is the chunk
+    for (int i = 0; i < 3; i++)
+      l[i] = Div58_10(r, l[i], &r);
+    chunk[k] = r;
+    r = 0;
+  }
+
+}
+
+static int EncodeChunks(const unsigned char *payload, uint64_t *chunk, char *str) {
+
+  char digits[40];
+
+  for (int k = 0; k < 4; k++) {
+    uint32_t hi = (uint32_t)(chunk[k] / B58_5);
+    uint32_t lo = (uint32_t)(chunk[k] % B58_5);
+    char *d = digits + 39 - 10 * k;
+    for (int i = 0; i < 5; i++) {
+      d[-i] = (char)(lo % 58);
+      lo /= 58;
+    }
+    for (int i = 5; i < 10; i++) {
+      d[-i] = (char)(hi % 58);
+      hi /= 58;
+    }
+  }
+
+  // One '1' per leading zero byte, then the significant digits
+  int len = 0;
+  for (int i = 0; i < 25 && payload[i] == 0; i++)
+    str[len++] = '1';
+  int first = 0;
+  while (first < 40 && digits[first] == 0)
+    first++;
+  for (int i = first; i < 40; i++)
+    str[len++] = pszBase58[(int)digits[i]];
+  str[len] = 0;
+  return len;
+
+}
+
+int EncodeBase58Address(const unsigned char* payload, char* str) {
+
+  uint64_t chunk[4];
+  Chunks58(payload, chunk);
+  return EncodeChunks(payload, chunk, str);
+
+}
+
 bool DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet)
 {
     return DecodeBase58(str.c_str(), vchRet);
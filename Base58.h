@@ -32,6 +32,18 @@ std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
  */
 std::string EncodeBase58(const std::vector<unsigned char>& vch);
 
+/**
+ * Size of the EncodeBase58Address() output buffer: at most 35 characters
+ * for a 25 bytes payload and the terminating zero.
+ */
+#define BASE58_ADDRESS_SIZE 36
+
+/**
+ * Encode a 25 bytes payload (version, hash160, checksum) as a zero terminated
+ * base58 string in str, without allocation. Returns the string length.
+ */
+int EncodeBase58Address(const unsigned char* payload, char* str);
+
 /**
  * Decode a base58-encoded string (psz) into a byte vector (vchRet).
  * return true if decoding is successful.
@@ -0,0 +1,824 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CPUEngine.h"
+#include "Random.h"
+#include "Timer.h"
+#include <string.h>
+#include <algorithm>
+#include <xmmintrin.h>
+
+#define _64K 65536
+
+using namespace std;
+
+CPUEngine::CPUEngine(Secp256K1 *secp, int nbThread, uint32_t maxFound) {
+
+  this->secp = secp;
+  this->nbThread = nbThread;
+  this->maxFound = maxFound;
+  nbFound = 0;
+  searchMode = SEARCH_COMPRESSED;
+  searchType = P2PKH;
+  lostWarning = false;
+  useEndo = false;
+  filter = NULL;
+  db = NULL;
+  usePipeline = false;
+  reportAll = false;
+
+  // beta^3 = 1 mod p, (beta*x,y) = lambda*(x,y)
+  beta.SetBase16("7ae96a2b657c07106e64479eac3434e99cf0497512f58995c1396c28719501ee");
+  beta2.SetBase16("851695d49a83f8ef919bb86153cbcb16630fb68aed0a766a3ec693d68e6afa40");
+
+  inputAddress.assign(_64K, 0);
+  keys.resize(nbThread);
+  outputHash.resize((size_t)maxFound * 20);
+  probes.resize(CPU_PROBE_DEPTH * CPU_HASH_BLOCK);
+  probeHead = 0;
+  nbPending = 0;
+
+  grp = new IntGroup(CPU_GRP_SIZE / 2 + 1);
+  dx = new Int[CPU_GRP_SIZE / 2 + 1];
+  pts = new Point[CPU_GRP_SIZE];
+  Gn = new Point[CPU_GRP_SIZE / 2];
+  grp->Set(dx);
+
+  // Compute Generator table G[n] = (n+1)*G
+  Point g = secp->G;
+  Gn[0] = g;
+  g = secp->DoubleDirect(g);
+  Gn[1] = g;
+  for (int i = 2; i < CPU_GRP_SIZE / 2; i++) {
+    g = secp->AddDirect(g, secp->G);
+    Gn[i] = g;
+  }
+  // _2Gn = CPU_GRP_SIZE*G
+  _2Gn = secp->DoubleDirect(Gn[CPU_GRP_SIZE / 2 - 1]);
+
+  char tmp[64];
+  sprintf(tmp, "CPU (%d lane%s)", nbThread, (nbThread > 1) ? "s" : "");
+  deviceName = std::string(tmp);
+
+}
+
+CPUEngine::~CPUEngine() {
+
+  delete grp;
+  delete[] dx;
+  delete[] pts;
+  delete[] Gn;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+int CPUEngine::GetNbThread() {
+  return nbThread;
+}
+
+int CPUEngine::GetGroupSize() {
+  return CPU_GRP_SIZE;
+}
+
+int CPUEngine::GetStepSize() {
+  return CPU_GRP_SIZE;
+}
+
+void CPUEngine::SetSearchMode(int searchMode) {
+  this->searchMode = searchMode;
+}
+
+void CPUEngine::SetSearchType(int searchType) {
+  this->searchType = searchType;
+}
+
+void CPUEngine::SetEndomorphism(bool enable) {
+  useEndo = enable;
+}
+
+void CPUEngine::SetFilter(XorFilter *filter) {
+  this->filter = filter;
+  UpdateProbeMode();
+}
+
+void CPUEngine::SetTargetDB(TargetDB *db) {
+  this->db = db;
+  UpdateProbeMode();
+}
+
+void CPUEngine::SetReportAll(bool enable) {
+  reportAll = enable;
+  UpdateProbeMode();
+}
+
+// The lookup pipeline only pays off once the second level (32 bits table,
+// database or xor filter) is out of the caches.
+void CPUEngine::UpdateProbeMode() {
+
+  size_t table = 0;
+  if (filter)
+    table = filter->GetMemory();
+  else if (db)
+    table = (size_t)db->GetSize() * 20;
+  else
+    table = inputAddressLookUp.size() * sizeof(uint32_t);
+  usePipeline = !reportAll && (table >= CPU_PROBE_MIN_TABLE);
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+void CPUEngine::SetAddress(std::vector<address_t> addresses) {
+
+  inputAddress.assign(_64K, 0);
+  inputAddressLookUp.clear();
+  for (int i = 0; i < (int)addresses.size(); i++)
+    inputAddress[addresses[i]] = 1;
+  lostWarning = false;
+  UpdateProbeMode();
+
+}
+
+void CPUEngine::SetAddress(std::vector<LADDRESS> addresses, uint32_t totalAddress) {
+
+  // Same layout as the GPU: hit count in the 16 bits table,
+  // offset of the sorted 32 bits addresses in the first 64K lookup items
+  inputAddress.assign(_64K, 0);
+  inputAddressLookUp.assign(_64K + totalAddress, 0);
+
+  uint32_t offset = _64K;
+  for (int i = 0; i < (int)addresses.size(); i++) {
+    int nbLAddress = (int)addresses[i].lAddresses.size();
+    inputAddress[addresses[i].sAddress] = (uint16_t)nbLAddress;
+    inputAddressLookUp[addresses[i].sAddress] = offset;
+    for (int j = 0; j < nbLAddress; j++) {
+      inputAddressLookUp[offset++] = addresses[i].lAddresses[j];
+    }
+  }
+
+  if (offset != (_64K + totalAddress)) {
+    printf("CPUEngine: Wrong totalAddress %d!=%d!\n", offset - _64K, totalAddress);
+  }
+  lostWarning = false;
+  UpdateProbeMode();
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+bool CPUEngine::SetKeys(Point *p) {
+
+  // Sets the starting keys (group center) for each lane
+  // p must contains nbThread public keys
+  for (int i = 0; i < nbThread; i++)
+    keys[i] = p[i];
+
+  return true;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+void CPUEngine::ComputeGroup(Point &startP) {
+
+  // Fill pts[i] = startP + (i - CPU_GRP_SIZE/2)*G and move startP to the next center
+  int i;
+  int hLength = (CPU_GRP_SIZE / 2 - 1);
+  Int dy;
+  Int dyn;
+  Int _s;
+  Int _p;
+  Point pp;
+  Point pn;
+
+  for (i = 0; i < hLength; i++) {
+    dx[i].ModSub(&Gn[i].x, &startP.x);
+  }
+  dx[i].ModSub(&Gn[i].x, &startP.x);  // For the first point
+  dx[i + 1].ModSub(&_2Gn.x, &startP.x); // For the next center point
+
+  // Grouped ModInv
+  grp->ModInv();
+
+  // We use the fact that P + i*G and P - i*G has the same deltax, so the same inverse
+  // We compute key in the positive and negative way from the center of the group
+
+  // center point
+  pts[CPU_GRP_SIZE / 2] = startP;
+
+  for (i = 0; i < hLength; i++) {
+
+    pp = startP;
+    pn = startP;
+
+    // P = startP + i*G
+    dy.ModSub(&Gn[i].y, &pp.y);
+
+    _s.ModMulK1(&dy, &dx[i]);       // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+    _p.ModSquareK1(&_s);            // _p = pow2(s)
+
+    pp.x.ModNeg();
+    pp.x.ModAdd(&_p);
+    pp.x.ModSub(&Gn[i].x);           // rx = pow2(s) - p1.x - p2.x;
+
+    pp.y.ModSub(&Gn[i].x, &pp.x);
+    pp.y.ModMulK1(&_s);
+    pp.y.ModSub(&Gn[i].y);           // ry = - p2.y - s*(ret.x-p2.x);
+
+    // P = startP - i*G  , if (x,y) = i*G then (x,-y) = -i*G
+    dyn.Set(&Gn[i].y);
+    dyn.ModNeg();
+    dyn.ModSub(&pn.y);
+
+    _s.ModMulK1(&dyn, &dx[i]);      // s = (p2.y-p1.y)*inverse(p2.x-p1.x);
+    _p.ModSquareK1(&_s);            // _p = pow2(s)
+
+    pn.x.ModNeg();
+    pn.x.ModAdd(&_p);
+    pn.x.ModSub(&Gn[i].x);          // rx = pow2(s) - p1.x - p2.x;
+
+    pn.y.ModSub(&Gn[i].x, &pn.x);
+    pn.y.ModMulK1(&_s);
+    pn.y.ModAdd(&Gn[i].y);          // ry = - p2.y - s*(ret.x-p2.x);
+
+    pts[CPU_GRP_SIZE / 2 + (i + 1)] = pp;
+    pts[CPU_GRP_SIZE / 2 - (i + 1)] = pn;
+
+  }
+
+  // First point (startP - (GRP_SZIE/2)*G)
+  pn = startP;
+  dyn.Set(&Gn[i].y);
+  dyn.ModNeg();
+  dyn.ModSub(&pn.y);
+
+  _s.ModMulK1(&dyn, &dx[i]);
+  _p.ModSquareK1(&_s);
+
+  pn.x.ModNeg();
+  pn.x.ModAdd(&_p);
+  pn.x.ModSub(&Gn[i].x);
+
+  pn.y.ModSub(&Gn[i].x, &pn.x);
+  pn.y.ModMulK1(&_s);
+  pn.y.ModAdd(&Gn[i].y);
+
+  pts[0] = pn;
+
+  // Next start point (startP + GRP_SIZE*G)
+  pp = startP;
+  dy.ModSub(&_2Gn.y, &pp.y);
+
+  _s.ModMulK1(&dy, &dx[i + 1]);
+  _p.ModSquareK1(&_s);
+
+  pp.x.ModNeg();
+  pp.x.ModAdd(&_p);
+  pp.x.ModSub(&_2Gn.x);
+
+  pp.y.ModSub(&_2Gn.x, &pp.x);
+  pp.y.ModMulK1(&_s);
+  pp.y.ModSub(&_2Gn.y);
+  startP = pp;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+void CPUEngine::CheckPoint(uint8_t *h, uint32_t tid, int32_t incr, int endo, bool mode, std::vector<ITEM> &found) {
+
+  if (!reportAll) {
+
+    // Lookup table
+    address_t pr0 = *(address_t *)h;
+    address_t hit = inputAddress[pr0];
+    if (!hit)
+      return;
+
+    if (filter) {
+      if (!filter->Contain(XorFilter::HashKey(h)))
+        return;
+    } else if (db) {
+      if (db->Find(h) < 0)
+        return;
+    } else if (inputAddressLookUp.size()) {
+      uint32_t off = inputAddressLookUp[pr0];
+      addressl_t l32 = *(addressl_t *)h;
+      if (!std::binary_search(inputAddressLookUp.begin() + off, inputAddressLookUp.begin() + off + hit, l32))
+        return;
+    }
+
+  }
+
+  if (nbFound < maxFound) {
+    uint8_t *hash = outputHash.data() + (size_t)nbFound * 20;
+    memcpy(hash, h, 20);
+    ITEM it;
+    it.thId = tid;
+    it.incr = (int16_t)incr;
+    it.endo = (int16_t)endo;
+    it.mode = mode;
+    it.hash = hash;
+    found.push_back(it);
+  }
+  nbFound++;
+
+}
+
+// Stage 1, 16 bits table entries
+void CPUEngine::PrefetchProbes(PROBE *p) {
+
+  for (int i = 0; i < CPU_HASH_BLOCK; i++)
+    _mm_prefetch((const char *)&inputAddress[*(address_t *)p[i].h], _MM_HINT_T0);
+
+}
+
+// Stage 2, 16 bits hits and prefetch of their second level
+void CPUEngine::ReadProbes(PROBE *p) {
+
+  for (int i = 0; i < CPU_HASH_BLOCK; i++) {
+    address_t pr0 = *(address_t *)p[i].h;
+    p[i].hit = (inputAddress[pr0] != 0);
+    if (!p[i].hit)
+      continue;
+    if (filter)
+      filter->Prefetch(XorFilter::HashKey(p[i].h));
+    else if (db)
+      db->Prefetch(p[i].h);
+    else if (inputAddressLookUp.size()) {
+      // Lines of the sorted bucket the binary search goes through
+      const uint32_t *b = inputAddressLookUp.data() + inputAddressLookUp[pr0];
+      for (uint32_t j = 0; j < inputAddress[pr0]; j += 16)
+        _mm_prefetch((const char *)(b + j), _MM_HINT_T0);
+    }
+  }
+
+}
+
+// Stage 3
+void CPUEngine::ResolveProbes(uint32_t tid, PROBE *p, std::vector<ITEM> &found) {
+
+  for (int i = 0; i < CPU_HASH_BLOCK; i++)
+    if (p[i].hit)
+      CheckPoint(p[i].h, tid, p[i].incr, p[i].endo, p[i].mode, found);
+
+}
+
+// Slot of the next block, its previous block was resolved by CommitProbes()
+PROBE *CPUEngine::ReserveProbes() {
+  return probes.data() + (probeHead % CPU_PROBE_DEPTH) * CPU_HASH_BLOCK;
+}
+
+// The reserved block is hashed, advance the pipeline
+void CPUEngine::CommitProbes(uint32_t tid, std::vector<ITEM> &found) {
+
+  PrefetchProbes(ReserveProbes());
+  if (nbPending >= 1)
+    ReadProbes(probes.data() + ((probeHead - 1) % CPU_PROBE_DEPTH) * CPU_HASH_BLOCK);
+  if (nbPending >= 2) {
+    ResolveProbes(tid, probes.data() + ((probeHead - 2) % CPU_PROBE_DEPTH) * CPU_HASH_BLOCK, found);
+    nbPending--;
+  }
+  probeHead++;
+  nbPending++;
+
+}
+
+void CPUEngine::FlushProbes(uint32_t tid, std::vector<ITEM> &found) {
+
+  // Pending blocks (at most 2), oldest first, only the last one is not read
+  for (int b = nbPending; b > 0; b--) {
+    PROBE *p = probes.data() + ((probeHead - b) % CPU_PROBE_DEPTH) * CPU_HASH_BLOCK;
+    if (b == 1)
+      ReadProbes(p);
+    ResolveProbes(tid, p, found);
+  }
+  nbPending = 0;
+
+}
+
+void CPUEngine::CheckBlock(uint32_t tid, Point *p, int i, int endo, bool sym, std::vector<ITEM> &found) {
+
+  // Hash CPU_HASH_BLOCK points in the searched forms, with SEARCH_BOTH the
+  // compressed and uncompressed hash160 come from the same affine points
+  if (searchMode != SEARCH_UNCOMPRESSED)
+    HashBlock(tid, p, i, endo, sym, true, found);
+  if (searchMode != SEARCH_COMPRESSED)
+    HashBlock(tid, p, i, endo, sym, false, found);
+
+}
+
+void CPUEngine::HashBlock(uint32_t tid, Point *p, int i, int endo, bool sym, bool mode, std::vector<ITEM> &found) {
+
+  int32_t sign = sym ? -1 : 1;
+  uint8_t *h[CPU_HASH_BLOCK];
+
+  if (!usePipeline) {
+    uint8_t hs[CPU_HASH_BLOCK][20];
+    for (int j = 0; j < CPU_HASH_BLOCK; j++)
+      h[j] = hs[j];
+    secp->GetHash160(searchType, mode, p, h, CPU_HASH_BLOCK);
+    for (int j = 0; j < CPU_HASH_BLOCK; j++)
+      CheckPoint(hs[j], tid, sign * (i + j), endo, mode, found);
+    return;
+  }
+
+  PROBE *pr = ReserveProbes();
+  for (int j = 0; j < CPU_HASH_BLOCK; j++)
+    h[j] = pr[j].h;
+  secp->GetHash160(searchType, mode, p, h, CPU_HASH_BLOCK);
+  for (int j = 0; j < CPU_HASH_BLOCK; j++) {
+    pr[j].incr = sign * (i + j);
+    pr[j].endo = (int16_t)endo;
+    pr[j].mode = mode;
+  }
+  CommitProbes(tid, found);
+
+}
+
+void CPUEngine::CheckGroup(uint32_t tid, std::vector<ITEM> &found) {
+
+  for (int i = 0; i < CPU_GRP_SIZE; i += CPU_HASH_BLOCK)
+    CheckBlock(tid, pts + i, i, 0, false, found);
+  FlushProbes(tid, found);
+
+}
+
+void CPUEngine::CheckGroupEndo(uint32_t tid, std::vector<ITEM> &found) {
+
+  Point p[CPU_HASH_BLOCK];
+
+  for (int i = 0; i < CPU_GRP_SIZE; i += CPU_HASH_BLOCK) {
+
+    for (int j = 0; j < CPU_HASH_BLOCK; j++)
+      p[j] = pts[i + j];
+
+    // (x,y), (beta*x,y), (beta^2*x,y)
+    CheckBlock(tid, p, i, 0, false, found);
+    for (int j = 0; j < CPU_HASH_BLOCK; j++) p[j].x.ModMulK1(&pts[i + j].x, &beta);
+    CheckBlock(tid, p, i, 1, false, found);
+    for (int j = 0; j < CPU_HASH_BLOCK; j++) p[j].x.ModMulK1(&pts[i + j].x, &beta2);
+    CheckBlock(tid, p, i, 2, false, found);
+
+    // Symmetric points, if (x,y) = k*G then (x,-y) = -k*G
+    for (int j = 0; j < CPU_HASH_BLOCK; j++) {
+      p[j].x.Set(&pts[i + j].x);
+      p[j].y.ModNeg();
+    }
+    CheckBlock(tid, p, i, 0, true, found);
+    for (int j = 0; j < CPU_HASH_BLOCK; j++) p[j].x.ModMulK1(&pts[i + j].x, &beta);
+    CheckBlock(tid, p, i, 1, true, found);
+    for (int j = 0; j < CPU_HASH_BLOCK; j++) p[j].x.ModMulK1(&pts[i + j].x, &beta2);
+    CheckBlock(tid, p, i, 2, true, found);
+
+  }
+  FlushProbes(tid, found);
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+bool CPUEngine::Launch(std::vector<ITEM> &addressFound, bool spinWait) {
+
+  addressFound.clear();
+  nbFound = 0;
+
+  for (int t = 0; t < nbThread; t++) {
+
+    ComputeGroup(keys[t]);
+
+    if (useEndo)
+      CheckGroupEndo(t, addressFound);
+    else
+      CheckGroup(t, addressFound);
+
+  }
+
+  if (nbFound > maxFound && !lostWarning) {
+    // address has been lost
+    printf("\nWarning, %d items lost\nHint: Search with less addresses/prefixes or increase maxFound (-m) using multiple of 65536\n", (nbFound - maxFound));
+    lostWarning = true;
+  }
+
+  return true;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+bool CPUEngine::Check(Secp256K1 *secp) {
+
+  // Plant targets at both ends and in the middle of a group, in different lanes,
+  // launches and forms (SEARCH_BOTH), then check that the ITEMs give back the
+  // private keys and the key form
+  struct {
+    int lane;
+    int launch;
+    int incr;
+    bool compressed;
+  } targets[] = {
+    { 0,0,0,true },
+    { nbThread - 1,0,CPU_GRP_SIZE / 2,false },
+    { nbThread / 2,0,CPU_GRP_SIZE - 1,true },
+    { 1 % nbThread,1,123,false },
+    { (nbThread * 3) / 4,1,CPU_GRP_SIZE / 2 + 1,true },
+  };
+  int nbTarget = sizeof(targets) / sizeof(targets[0]);
+
+  printf("CPUEngine: Check %d lanes: ", nbThread);
+
+  Int rangeStart;
+  Int stepThread;
+  rangeStart.Rand(128);
+  stepThread.SetInt32(1);
+  stepThread.ShiftL(40);
+
+  Int tKeys[5];
+  std::vector<LADDRESS> lookup;
+  for (int i = 0; i < nbTarget; i++) {
+    tKeys[i].Set(&stepThread);
+    tKeys[i].Mult((uint64_t)targets[i].lane);
+    tKeys[i].Add(&rangeStart);
+    tKeys[i].Add((uint64_t)(targets[i].launch * GetStepSize() + targets[i].incr));
+    Point P = secp->ComputePublicKey(&tKeys[i]);
+    unsigned char h[20];
+    secp->GetHash160(P2PKH, targets[i].compressed, P, h);
+    address_t s = *(address_t *)h;
+    int j = 0;
+    while (j < (int)lookup.size() && lookup[j].sAddress != s) j++;
+    if (j == (int)lookup.size()) {
+      LADDRESS la;
+      la.sAddress = s;
+      lookup.push_back(la);
+    }
+    lookup[j].lAddresses.push_back(*(addressl_t *)h);
+  }
+  for (int i = 0; i < (int)lookup.size(); i++)
+    std::sort(lookup[i].lAddresses.begin(), lookup[i].lAddresses.end());
+
+  SetSearchMode(SEARCH_BOTH);
+  SetSearchType(P2PKH);
+  SetAddress(lookup, nbTarget);
+
+  std::vector<Point> p(nbThread);
+  for (int t = 0; t < nbThread; t++) {
+    Int k(&stepThread);
+    k.Mult((uint64_t)t);
+    k.Add(&rangeStart);
+    k.Add((uint64_t)(GetGroupSize() / 2));
+    p[t] = secp->ComputePublicKey(&k);
+  }
+
+  // Point by point lookup, then the lookup pipeline
+  int nbOK = 0;
+  int nbItem = 0;
+  std::vector<ITEM> found;
+  for (int launch = 0; launch < 4; launch++) {
+
+    if (launch % 2 == 0) {
+      SetKeys(p.data());
+      usePipeline = (launch == 2);
+    }
+    Launch(found);
+    nbItem += (int)found.size();
+
+    for (int i = 0; i < (int)found.size(); i++) {
+      Int k(&stepThread);
+      k.Mult((uint64_t)found[i].thId);
+      k.Add(&rangeStart);
+      k.Add((uint64_t)((launch % 2) * GetStepSize() + found[i].incr));
+      for (int j = 0; j < nbTarget; j++) {
+        if (k.IsEqual(&tKeys[j]) && found[i].mode == targets[j].compressed) {
+          Point P = secp->ComputePublicKey(&k);
+          unsigned char h[20];
+          secp->GetHash160(P2PKH, found[i].mode, P, h);
+          if (memcmp(h, found[i].hash, 20) == 0)
+            nbOK++;
+        }
+      }
+    }
+
+  }
+
+  UpdateProbeMode();
+  bool ok = (nbOK == 2 * nbTarget) && (nbItem == 2 * nbTarget);
+  if (ok) {
+    printf("OK\n");
+  } else {
+    printf("Failed ! (%d/%d keys, %d items)\n", nbOK, 2 * nbTarget, nbItem);
+  }
+
+  return CheckEndo(secp) && ok;
+
+}
+
+bool CPUEngine::CheckEndo(Secp256K1 *secp) {
+
+  // Plant one target per candidate kind (lambda^e * (+/-k)) in lane 0,
+  // then rebuild the keys from the ITEMs like VanitySearch::checkPrivKey
+  Int lambda;
+  Int lambda2;
+  lambda.SetBase16("5363ad4cc05c30e0a5261c028812645a122e22ea20816678df02967c1b23bd72");
+  lambda2.SetBase16("ac9c52b33fa3cf1f5ad9e3fd77ed9ba4a880b9fc8ec739c2e0cfc810b51283ce");
+
+  printf("CPUEngine: Check endomorphisms: ");
+
+  Int base;
+  base.Rand(128);
+
+  struct {
+    int incr;
+    int endo;
+    bool neg;
+  } targets[] = {
+    { 3,1,false },
+    { CPU_GRP_SIZE / 2,2,false },
+    { CPU_GRP_SIZE - 1,0,true },
+    { 17,1,true },
+    { CPU_GRP_SIZE / 2 + 5,2,true },
+    { 1,0,false },
+  };
+  int nbTarget = sizeof(targets) / sizeof(targets[0]);
+
+  auto rebuild = [&](int32_t incr, int endo, Int &k) {
+    k.Set(&base);
+    if (incr < 0) {
+      k.Add((uint64_t)(-incr));
+      k.Neg();
+      k.Add(&secp->order);
+    } else {
+      k.Add((uint64_t)incr);
+    }
+    if (endo == 1) k.ModMulK1order(&lambda);
+    if (endo == 2) k.ModMulK1order(&lambda2);
+  };
+
+  std::vector<LADDRESS> lookup;
+  std::vector<Int> tKeys(nbTarget);
+  for (int i = 0; i < nbTarget; i++) {
+    rebuild(targets[i].neg ? -targets[i].incr : targets[i].incr, targets[i].endo, tKeys[i]);
+    Point P = secp->ComputePublicKey(&tKeys[i]);
+    unsigned char h[20];
+    secp->GetHash160(P2PKH, true, P, h);
+    LADDRESS la;
+    la.sAddress = *(address_t *)h;
+    la.lAddresses.push_back(*(addressl_t *)h);
+    lookup.push_back(la);
+  }
+  // Merge same 16 bits prefixes
+  std::sort(lookup.begin(), lookup.end(), [](const LADDRESS &a, const LADDRESS &b) { return a.sAddress < b.sAddress; });
+  for (int i = (int)lookup.size() - 1; i > 0; i--) {
+    if (lookup[i].sAddress == lookup[i - 1].sAddress) {
+      lookup[i - 1].lAddresses.push_back(lookup[i].lAddresses[0]);
+      std::sort(lookup[i - 1].lAddresses.begin(), lookup[i - 1].lAddresses.end());
+      lookup.erase(lookup.begin() + i);
+    }
+  }
+
+  SetSearchMode(SEARCH_COMPRESSED);
+  SetSearchType(P2PKH);
+  SetAddress(lookup, nbTarget);
+  SetEndomorphism(true);
+
+  std::vector<Point> p(nbThread);
+  for (int t = 0; t < nbThread; t++) {
+    Int k(&base);
+    k.Add((uint64_t)(GetGroupSize() / 2 + t * GetStepSize() * 2));
+    p[t] = secp->ComputePublicKey(&k);
+  }
+  SetKeys(p.data());
+
+  std::vector<ITEM> found;
+  Launch(found);
+  SetEndomorphism(false);
+
+  int nbOK = 0;
+  for (int i = 0; i < (int)found.size(); i++) {
+    if (found[i].thId != 0)
+      continue;
+    Int k;
+    rebuild(found[i].incr, found[i].endo, k);
+    Point P = secp->ComputePublicKey(&k);
+    unsigned char h[20];
+    secp->GetHash160(P2PKH, true, P, h);
+    if (memcmp(h, found[i].hash, 20) == 0)
+      nbOK++;
+  }
+
+  bool ok = (nbOK == nbTarget) && ((int)found.size() == nbTarget);
+  if (ok) {
+    printf("OK\n");
+  } else {
+    printf("Failed ! (%d/%d keys, %d items)\n", nbOK, nbTarget, (int)found.size());
+  }
+  return ok;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+void CPUEngine::BenchProbe() {
+
+  // Hash160 of the points of a group as in Launch(), so that the lookups
+  // are interleaved with the hashing. The hashes are perturbed by a counter
+  // so that no table entry is reused from a previous pass over the group.
+  const int nbProbeHash = 1 << 20;
+  std::vector<ITEM> found;
+  XorFilter f;
+  Int k;
+  k.Rand(256);
+  Point startP = secp->ComputePublicKey(&k);
+  ComputeGroup(startP);
+
+  printf("CPUEngine: hash160 + lookup (Mprobe/s), %d probes\n", nbProbeHash);
+  printf("%10s %12s %12s %12s %12s %12s\n", "Targets", "Hash only", "L32 scalar", "L32 batch", "Xor scalar", "Xor batch");
+
+  for (int bits = 10; bits <= 22; bits += 4) {
+
+    int nbTarget = 1 << bits;
+    std::vector<std::vector<addressl_t>> buckets(_64K);
+    std::vector<uint64_t> fKeys(nbTarget);
+    for (int i = 0; i < nbTarget; i++) {
+      uint8_t h[20];
+      for (int j = 0; j < 20; j += 4) {
+        uint32_t r = rndl();
+        memcpy(h + j, &r, 4);
+      }
+      buckets[*(address_t *)h].push_back(*(addressl_t *)h);
+      fKeys[i] = XorFilter::HashKey(h);
+    }
+    std::vector<LADDRESS> lookup;
+    for (int i = 0; i < _64K; i++) {
+      if (buckets[i].size() == 0)
+        continue;
+      LADDRESS l;
+      l.sAddress = (address_t)i;
+      l.lAddresses = buckets[i];
+      std::sort(l.lAddresses.begin(), l.lAddresses.end());
+      lookup.push_back(l);
+    }
+    SetAddress(lookup, nbTarget);
+    f.Build(fKeys);
+
+    double rate[5];
+    for (int m = 0; m < 5; m++) {
+      SetFilter((m >= 3) ? &f : NULL);
+      bool batch = (m == 2 || m == 4);
+      found.clear();
+      nbFound = 0;
+      double t0 = Timer::get_tick();
+      for (int n = 0; n < nbProbeHash; n += CPU_HASH_BLOCK) {
+        Point *p = pts + (n % CPU_GRP_SIZE);
+        uint64_t perturb = (uint64_t)n * 0x9E3779B97F4A7C15ULL;
+        uint8_t *hp[CPU_HASH_BLOCK];
+        if (batch) {
+          PROBE *pr = ReserveProbes();
+          for (int j = 0; j < CPU_HASH_BLOCK; j++)
+            hp[j] = pr[j].h;
+          secp->GetHash160(P2PKH, true, p, hp, CPU_HASH_BLOCK);
+          for (int j = 0; j < CPU_HASH_BLOCK; j++) {
+            *(uint64_t *)pr[j].h ^= perturb;
+            pr[j].incr = n + j;
+            pr[j].endo = 0;
+            pr[j].mode = true;
+          }
+          CommitProbes(0, found);
+        } else {
+          unsigned char h[CPU_HASH_BLOCK][20];
+          for (int j = 0; j < CPU_HASH_BLOCK; j++)
+            hp[j] = h[j];
+          secp->GetHash160(P2PKH, true, p, hp, CPU_HASH_BLOCK);
+          for (int j = 0; j < CPU_HASH_BLOCK && m > 0; j++) {
+            *(uint64_t *)h[j] ^= perturb;
+            CheckPoint(h[j], 0, n + j, 0, true, found);
+          }
+        }
+      }
+      FlushProbes(0, found);
+      double t1 = Timer::get_tick();
+      rate[m] = (double)nbProbeHash / ((t1 - t0) * 1e6);
+    }
+
+    printf("%10d %12.2f %12.2f %12.2f %12.2f %12.2f\n", nbTarget, rate[0], rate[1], rate[2], rate[3], rate[4]);
+
+  }
+
+  SetFilter(NULL);
+  nbFound = 0;
+
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CPUENGINEH
+#define CPUENGINEH
+
+#include <vector>
+#include "ComputeEngine.h"
+#include "IntGroup.h"
+#include "XorFilter.h"
+#include "TargetDB.h"
+
+// Number of key per CPU lane group (one IntGroup::ModInv per group)
+#define CPU_GRP_SIZE 1024
+
+// Points hashed per GetHash160() call: one call of the AVX-512 kernel
+// (16 lanes), two of the AVX2 one or four of the SSE one
+#define CPU_HASH_BLOCK 16
+
+// Lookup pipeline depth in hash blocks: the 16 bits entries of a block are
+// prefetched when it is hashed, read (second level prefetched) after the
+// next block and resolved after the one after, so the memory accesses
+// overlap the hashing of the following blocks
+#define CPU_PROBE_DEPTH 3
+
+// Second level table size (bytes) from which the lookup pipeline is used,
+// smaller tables are looked up point by point (-bench, 1M 32 bits targets,
+// 850K xor filter targets)
+#define CPU_PROBE_MIN_TABLE (4 << 20)
+
+typedef struct {
+
+  uint8_t h[20];
+  int32_t incr;
+  int16_t endo;
+  bool mode;
+  bool hit;
+
+} PROBE;
+
+// Host implementation of the comp_keys kernel: same lane layout, same
+// 16/32 bits lookup and same ITEM output, so it can replace a GPUEngine
+class CPUEngine : public ComputeEngine {
+
+public:
+
+  CPUEngine(Secp256K1 *secp, int nbThread, uint32_t maxFound);
+  ~CPUEngine();
+  void SetAddress(std::vector<address_t> addresses);
+  void SetAddress(std::vector<LADDRESS> addresses,uint32_t totalAddress);
+  bool SetKeys(Point *p);
+  void SetSearchMode(int searchMode);
+  void SetSearchType(int searchType);
+  bool Launch(std::vector<ITEM> &addressFound,bool spinWait=false);
+  int GetNbThread();
+  int GetGroupSize();
+  int GetStepSize();
+
+  // Also check (beta*x,y), (beta^2*x,y) and the 3 symmetric points (x,-y),
+  // 6 hash160 per point for one point addition. The ITEM has endo 1 or 2
+  // for the endomorphisms and a negative incr for the symmetric points.
+  void SetEndomorphism(bool enable);
+
+  // Full hash160 filter replacing the 32 bits lookup (onlyFull mode)
+  void SetFilter(XorFilter *filter);
+
+  // Mapped target database as second level lookup (onlyFull mode)
+  void SetTargetDB(TargetDB *db);
+
+  // Report every point, whatever the lookup tables: wildcard patterns are
+  // matched by the caller on the address string
+  void SetReportAll(bool enable);
+
+  bool Check(Secp256K1 *secp);
+
+  // Lookup throughput (probes/s) for several target table sizes
+  void BenchProbe();
+
+private:
+
+  void ComputeGroup(Point &startP);
+  void CheckPoint(uint8_t *h, uint32_t tid, int32_t incr, int endo, bool mode, std::vector<ITEM> &found);
+  PROBE *ReserveProbes();
+  void CommitProbes(uint32_t tid, std::vector<ITEM> &found);
+  void FlushProbes(uint32_t tid, std::vector<ITEM> &found);
+  void PrefetchProbes(PROBE *p);
+  void ReadProbes(PROBE *p);
+  void ResolveProbes(uint32_t tid, PROBE *p, std::vector<ITEM> &found);
+  void CheckBlock(uint32_t tid, Point *p, int i, int endo, bool sym, std::vector<ITEM> &found);
+  void HashBlock(uint32_t tid, Point *p, int i, int endo, bool sym, bool mode, std::vector<ITEM> &found);
+  void UpdateProbeMode();
+  void CheckGroup(uint32_t tid, std::vector<ITEM> &found);
+  void CheckGroupEndo(uint32_t tid, std::vector<ITEM> &found);
+  bool CheckEndo(Secp256K1 *secp);
+
+  Secp256K1 *secp;
+  int nbThread;
+  uint32_t maxFound;
+  uint32_t nbFound;
+  int searchMode;
+  int searchType;
+  bool lostWarning;
+  bool useEndo;
+  XorFilter *filter;
+  TargetDB *db;
+  bool usePipeline;
+  bool reportAll;
+
+  std::vector<address_t> inputAddress;
+  std::vector<uint32_t> inputAddressLookUp;
+  std::vector<Point> keys;
+  std::vector<uint8_t> outputHash;
+  std::vector<PROBE> probes;
+  uint32_t probeHead;
+  int nbPending;
+
+  IntGroup *grp;
+  Int *dx;
+  Point *pts;
+  Point *Gn;
+  Point _2Gn;
+  Int beta;
+  Int beta2;
+
+};
+
+#endif // CPUENGINEH
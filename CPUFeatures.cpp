@@ -0,0 +1,129 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CPUFeatures.h"
+#include "hash/sha256.h"
+#include <stdint.h>
+#ifdef WIN64
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+bool CPUFeatures::ssse3 = false;
+bool CPUFeatures::sse41 = false;
+bool CPUFeatures::avx2 = false;
+bool CPUFeatures::avx512 = false;
+bool CPUFeatures::sha = false;
+bool CPUFeatures::bmi2 = false;
+bool CPUFeatures::adx = false;
+
+static void cpuid(uint32_t leaf, uint32_t *r) {
+#ifdef WIN64
+  __cpuidex((int *)r, (int)leaf, 0);
+#else
+  __cpuid_count(leaf, 0, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+// Register state enabled by the OS (XCR0)
+static uint64_t xgetbv() {
+#ifdef WIN64
+  return _xgetbv(0);
+#else
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+void CPUFeatures::Init() {
+
+  uint32_t r[4];
+  cpuid(0, r);
+  uint32_t maxLeaf = r[0];
+
+  // CPUID.1:ECX SSSE3[9], SSE4.1[19], OSXSAVE[27], AVX[28]
+  cpuid(1, r);
+  ssse3 = (r[2] >> 9) & 1;
+  sse41 = (r[2] >> 19) & 1;
+  bool osxsave = (r[2] >> 27) & 1;
+  bool avx = (r[2] >> 28) & 1;
+
+  // XMM/YMM state, and opmask/ZMM state for AVX-512
+  uint64_t xcr0 = osxsave ? xgetbv() : 0;
+  bool ymm = (xcr0 & 0x06) == 0x06;
+  bool zmm = (xcr0 & 0xE6) == 0xE6;
+
+  // CPUID.7.0:EBX AVX2[5], BMI2[8], AVX512F[16], ADX[19], SHA[29]
+  if (maxLeaf >= 7) {
+    cpuid(7, r);
+    avx2 = avx && ymm && ((r[1] >> 5) & 1);
+    bmi2 = (r[1] >> 8) & 1;
+    avx512 = zmm && ((r[1] >> 16) & 1);
+    adx = (r[1] >> 19) & 1;
+  }
+  sha = sha256shani_supported();
+
+}
+
+int CPUFeatures::GetHashLanes() {
+  if (avx512) return 16;
+  if (avx2) return 8;
+  if (sha) return 1;
+  return 4;
+}
+
+bool CPUFeatures::UseSSE4() {
+  return !sha;
+}
+
+std::string CPUFeatures::GetFeatures() {
+
+  std::string s;
+  if (ssse3) s += "SSSE3 ";
+  if (sse41) s += "SSE4.1 ";
+  if (avx2) s += "AVX2 ";
+  if (avx512) s += "AVX-512F ";
+  if (sha) s += "SHA ";
+  if (s.length() > 0) s.pop_back();
+  if (bmi2 || adx) {
+    s += " (informational:";
+    if (bmi2) s += " BMI2";
+    if (adx) s += " ADX";
+    s += ")";
+  }
+  return s;
+
+}
+
+std::string CPUFeatures::GetKernels() {
+
+  std::string s = "hash160 ";
+  switch (GetHashLanes()) {
+  case 16: s += "AVX-512 x16"; break;
+  case 8:  s += "AVX2 x8"; break;
+  case 4:  s += "SSE x4"; break;
+  default: s += "scalar SHA-NI"; break;
+  }
+  s += sha ? ", SHA-256 SHA-NI" : ", SHA-256 scalar";
+  // The field arithmetic (Int.h) is inline mulq/adc, the same code on
+  // every x86-64 CPU
+  s += ", field mul/adc";
+  return s;
+
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPUFEATURESH
+#define CPUFEATURESH
+
+#include <string>
+
+// x86-64 features detected at startup (cpuid and the OS saved register
+// state). The SIMD kernels are compiled for their own instruction set
+// whatever -march, the widest one the CPU supports is called.
+class CPUFeatures {
+
+public:
+
+  static void Init();
+
+  // Lanes of the hash160 kernel: 16 (AVX-512), 8 (AVX2), 4 (SSE) or 1
+  // (scalar SHA-NI, faster than SSE x4)
+  static int GetHashLanes();
+
+  // SSE x4 kernels for the groups of 4 (not with SHA-NI)
+  static bool UseSSE4();
+
+  // Detected features and kernel set, printed in the banner
+  static std::string GetFeatures();
+  static std::string GetKernels();
+
+  static bool ssse3;
+  static bool sse41;
+  static bool avx2;
+  static bool avx512;
+  static bool sha;
+
+  // Informational, no kernel depends on them (the field arithmetic of
+  // Int.h is plain mulq/adc)
+  static bool bmi2;
+  static bool adx;
+
+};
+
+#endif // CPUFEATURESH
@@ -0,0 +1,188 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Checkpoint.h"
+#include "hash/sha256.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <errno.h>
+#ifdef WIN64
+#include <Windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CHECKPOINT_VERSION 1
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+bool Checkpoint::Save(string fileName, CHECKPOINT &cp) {
+
+  string tmpName = fileName + ".tmp";
+
+  FILE *f = fopen(tmpName.c_str(), "w");
+  if (f == NULL) {
+    fprintf(stderr, "[ERROR] Checkpoint: cannot open %s %s\n", tmpName.c_str(), strerror(errno));
+    return false;
+  }
+
+  fprintf(f, "VanitySearch checkpoint %d\n", CHECKPOINT_VERSION);
+  fprintf(f, "start %s\n", cp.ksStart.GetBase16().c_str());
+  fprintf(f, "end %s\n", cp.ksFinish.GetBase16().c_str());
+  fprintf(f, "targets %u %s\n", cp.nbTarget, cp.targetDigest.c_str());
+  fprintf(f, "found %d\n", cp.nbFound);
+  fprintf(f, "elapsed %.0f\n", cp.elapsed);
+
+  // worker threadId nbLane stepSize nbLaunch rangeStart rangeEnd lowestKey
+  for (int i = 0; i < (int)cp.workers.size(); i++) {
+    CHECKPOINT_WORKER *w = &cp.workers[i];
+    Int lowestKey((uint64_t)w->stepSize);
+    lowestKey.Mult(w->nbLaunch);
+    lowestKey.Add(&w->rangeStart);
+    fprintf(f, "worker %d %d %d %llu %s %s %s\n", w->threadId, w->nbLane, w->stepSize,
+      (unsigned long long)w->nbLaunch, w->rangeStart.GetBase16().c_str(),
+      w->rangeEnd.GetBase16().c_str(), lowestKey.GetBase16().c_str());
+  }
+
+  bool ok = (fflush(f) == 0);
+#ifdef WIN64
+  ok = ok && (_commit(_fileno(f)) == 0);
+#else
+  ok = ok && (fsync(fileno(f)) == 0);
+#endif
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] Checkpoint: cannot write %s %s\n", tmpName.c_str(), strerror(errno));
+    remove(tmpName.c_str());
+    return false;
+  }
+
+#ifdef WIN64
+  ok = MoveFileExA(tmpName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+  ok = (rename(tmpName.c_str(), fileName.c_str()) == 0);
+#endif
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] Checkpoint: cannot rename %s to %s\n", tmpName.c_str(), fileName.c_str());
+    return false;
+  }
+
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool Checkpoint::Load(string fileName, CHECKPOINT &cp) {
+
+  ifstream inFile(fileName);
+  if (!inFile.is_open()) {
+    fprintf(stderr, "[ERROR] Checkpoint: cannot open %s %s\n", fileName.c_str(), strerror(errno));
+    return false;
+  }
+
+  string line;
+  int version = 0;
+  bool hasStart = false;
+  bool hasEnd = false;
+  bool hasTargets = false;
+
+  cp.workers.clear();
+  cp.nbFound = 0;
+  cp.elapsed = 0;
+
+  if (!getline(inFile, line) || sscanf(line.c_str(), "VanitySearch checkpoint %d", &version) != 1 ||
+      version != CHECKPOINT_VERSION) {
+    fprintf(stderr, "[ERROR] Checkpoint: %s is not a checkpoint file (version %d expected)\n", fileName.c_str(), CHECKPOINT_VERSION);
+    return false;
+  }
+
+  while (getline(inFile, line)) {
+
+    istringstream ss(line);
+    string key;
+    string v1, v2;
+    ss >> key;
+
+    if (key == "start") {
+      ss >> v1;
+      cp.ksStart.SetBase16((char *)v1.c_str());
+      hasStart = true;
+    } else if (key == "end") {
+      ss >> v1;
+      cp.ksFinish.SetBase16((char *)v1.c_str());
+      hasEnd = true;
+    } else if (key == "targets") {
+      ss >> cp.nbTarget >> cp.targetDigest;
+      hasTargets = !ss.fail();
+    } else if (key == "found") {
+      ss >> cp.nbFound;
+    } else if (key == "elapsed") {
+      ss >> cp.elapsed;
+    } else if (key == "worker") {
+      CHECKPOINT_WORKER w;
+      unsigned long long nbLaunch;
+      ss >> w.threadId >> w.nbLane >> w.stepSize >> nbLaunch >> v1 >> v2;
+      if (ss.fail() || w.nbLane <= 0 || w.stepSize <= 0) {
+        fprintf(stderr, "[ERROR] Checkpoint: invalid line \"%s\"\n", line.c_str());
+        return false;
+      }
+      w.nbLaunch = nbLaunch;
+      w.rangeStart.SetBase16((char *)v1.c_str());
+      w.rangeEnd.SetBase16((char *)v2.c_str());
+      cp.workers.push_back(w);
+    } else if (key.length() > 0) {
+      fprintf(stderr, "[ERROR] Checkpoint: invalid line \"%s\"\n", line.c_str());
+      return false;
+    }
+
+  }
+
+  if (!hasStart || !hasEnd || !hasTargets) {
+    fprintf(stderr, "[ERROR] Checkpoint: %s is incomplete\n", fileName.c_str());
+    return false;
+  }
+
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+string Checkpoint::TargetDigest(vector<string> &targets) {
+
+  vector<string> sorted(targets);
+  std::sort(sorted.begin(), sorted.end());
+
+  string all;
+  for (int i = 0; i < (int)sorted.size(); i++) {
+    all.append(sorted[i]);
+    all.append("\n");
+  }
+
+  unsigned char digest[32];
+  sha256((uint8_t *)all.data(), (int)all.length(), digest);
+  return sha256_hex(digest);
+
+}
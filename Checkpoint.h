@@ -0,0 +1,64 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHECKPOINTH
+#define CHECKPOINTH
+
+#include <string>
+#include <vector>
+#include "Int.h"
+
+// Progress of one search thread: every lane of the thread has completed
+// nbLaunch*stepSize keys from rangeStart + lane*(rangeSize/nbLane)
+typedef struct {
+
+  int threadId;
+  int nbLane;
+  int stepSize;
+  uint64_t nbLaunch;
+  Int rangeStart;
+  Int rangeEnd;
+
+} CHECKPOINT_WORKER;
+
+typedef struct {
+
+  Int ksStart;
+  Int ksFinish;
+  std::string targetDigest;
+  uint32_t nbTarget;
+  int nbFound;
+  double elapsed;
+  std::vector<CHECKPOINT_WORKER> workers;
+
+} CHECKPOINT;
+
+class Checkpoint {
+
+public:
+
+  // Write the checkpoint in fileName.tmp, flush it to disk then rename it,
+  // fileName always holds a complete checkpoint
+  static bool Save(std::string fileName, CHECKPOINT &cp);
+  static bool Load(std::string fileName, CHECKPOINT &cp);
+
+  // sha256 of the sorted target list, detects a resume with other targets
+  static std::string TargetDigest(std::vector<std::string> &targets);
+
+};
+
+#endif // CHECKPOINTH
@@ -0,0 +1,422 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChunkMap.h"
+#include "Random.h"
+#include <string.h>
+#include <errno.h>
+#ifdef WIN64
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define CHUNKMAP_MAGIC "VSCHUNK1"
+#define FEISTEL_ROUNDS 4
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+ChunkMap::ChunkMap() {
+
+  header = NULL;
+  bitmap = NULL;
+  mapSize = 0;
+  nbChunk = 0;
+  cursor = 0;
+  offset = 0;
+  pass = 0;
+  nbPass = 1;
+  halfBits = 1;
+#ifdef WIN64
+  hFile = INVALID_HANDLE_VALUE;
+  hMap = NULL;
+#else
+  fd = -1;
+#endif
+
+}
+
+ChunkMap::~ChunkMap() {
+  Close();
+}
+
+// ----------------------------------------------------------------------------
+
+bool ChunkMap::Open(string fileName, Int &ksStart, Int &ksFinish, int chunkBits, bool retake) {
+
+  this->fileName = fileName;
+  this->ksStart.Set(&ksStart);
+  this->ksFinish.Set(&ksFinish);
+
+  // Number of chunks, the last one may be partial
+  Int size;
+  Int rem;
+  size.Set(&ksFinish);
+  size.Sub(&ksStart);
+  size.AddOne();
+  chunkSize.SetInt32(1);
+  chunkSize.ShiftL(chunkBits);
+  Int q(&size);
+  q.Div(&chunkSize, &rem);
+  if (!rem.IsZero())
+    q.AddOne();
+
+  Int maxChunk((uint64_t)CHUNK_MAX_COUNT);
+  if (q.IsGreater(&maxChunk)) {
+    fprintf(stderr, "[ERROR] ChunkMap: too many chunks (2^%d keys per chunk), use a larger -chunk\n", chunkBits);
+    return false;
+  }
+  nbChunk = q.bits64[0];
+
+  // Feistel domain 2^(2*halfBits) >= nbChunk
+  int nbBits = 2;
+  while (nbBits < 64 && (1ULL << nbBits) < nbChunk)
+    nbBits += 2;
+  halfBits = nbBits / 2;
+
+  uint64_t expectedSize = sizeof(CHUNKMAP_HEADER) + ((nbChunk + 15) / 16) * 4;
+
+  // Create the map in a temporary file and publish it with an operation that
+  // fails when another process created it first
+#ifdef WIN64
+  bool exists = GetFileAttributesA(fileName.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+  struct stat st;
+  bool exists = stat(fileName.c_str(), &st) == 0;
+#endif
+
+  if (!exists) {
+
+    CHUNKMAP_HEADER h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHUNKMAP_MAGIC, 8);
+    h.chunkBits = chunkBits;
+    h.nbChunk = nbChunk;
+    h.key = ((uint64_t)rndl() << 32) | (uint64_t)rndl();
+    ksStart.Get32Bytes(h.ksStart);
+    ksFinish.Get32Bytes(h.ksFinish);
+
+    char tmpName[1024];
+    snprintf(tmpName, sizeof(tmpName), "%s.%08lx.tmp", fileName.c_str(), rndl());
+    FILE *f = fopen(tmpName, "wb");
+    if (f == NULL) {
+      fprintf(stderr, "[ERROR] ChunkMap: cannot create %s %s\n", tmpName, strerror(errno));
+      return false;
+    }
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    ok = ok && (fflush(f) == 0);
+#ifdef WIN64
+    ok = ok && (_chsize_s(_fileno(f), expectedSize) == 0);
+    ok = ok && (_commit(_fileno(f)) == 0);
+#else
+    ok = ok && (ftruncate(fileno(f), expectedSize) == 0);
+    ok = ok && (fsync(fileno(f)) == 0);
+#endif
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+      fprintf(stderr, "[ERROR] ChunkMap: cannot write %s %s\n", tmpName, strerror(errno));
+      remove(tmpName);
+      return false;
+    }
+
+#ifdef WIN64
+    MoveFileExA(tmpName, fileName.c_str(), MOVEFILE_WRITE_THROUGH);
+#else
+    if (link(tmpName, fileName.c_str()) != 0 && errno != EEXIST) {
+      fprintf(stderr, "[ERROR] ChunkMap: cannot create %s %s\n", fileName.c_str(), strerror(errno));
+      remove(tmpName);
+      return false;
+    }
+#endif
+    remove(tmpName);
+
+  }
+
+  if (!Map(fileName, expectedSize))
+    return false;
+
+  // Same range and chunk size, otherwise the states would be meaningless
+  uint8_t s[32];
+  uint8_t e[32];
+  ksStart.Get32Bytes(s);
+  ksFinish.Get32Bytes(e);
+  if (memcmp(header->magic, CHUNKMAP_MAGIC, 8) != 0 || header->chunkBits != (uint32_t)chunkBits ||
+      header->nbChunk != nbChunk || memcmp(header->ksStart, s, 32) != 0 || memcmp(header->ksFinish, e, 32) != 0) {
+    fprintf(stderr, "[ERROR] ChunkMap: %s was made for another range or chunk size\n", fileName.c_str());
+    Close();
+    return false;
+  }
+
+  // Each process starts at a random position of the common permutation so
+  // that concurrent processes do not race for the same chunks
+  cursor = 0;
+  pass = 0;
+  nbPass = retake ? 2 : 1;
+  offset = (((uint64_t)rndl() << 32) | (uint64_t)rndl()) % nbChunk;
+
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool ChunkMap::Map(string fileName, uint64_t size) {
+
+#ifdef WIN64
+
+  hFile = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "[ERROR] ChunkMap: cannot open %s\n", fileName.c_str());
+    return false;
+  }
+  LARGE_INTEGER fSize;
+  if (!GetFileSizeEx(hFile, &fSize) || (uint64_t)fSize.QuadPart < size) {
+    fprintf(stderr, "[ERROR] ChunkMap: %s is truncated\n", fileName.c_str());
+    Close();
+    return false;
+  }
+  hMap = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, 0, 0, NULL);
+  void *ptr = (hMap != NULL) ? MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size) : NULL;
+  if (ptr == NULL) {
+    fprintf(stderr, "[ERROR] ChunkMap: cannot map %s\n", fileName.c_str());
+    Close();
+    return false;
+  }
+
+#else
+
+  fd = open(fileName.c_str(), O_RDWR);
+  if (fd < 0) {
+    fprintf(stderr, "[ERROR] ChunkMap: cannot open %s %s\n", fileName.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < size) {
+    fprintf(stderr, "[ERROR] ChunkMap: %s is truncated\n", fileName.c_str());
+    Close();
+    return false;
+  }
+  void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    fprintf(stderr, "[ERROR] ChunkMap: cannot map %s %s\n", fileName.c_str(), strerror(errno));
+    Close();
+    return false;
+  }
+
+#endif
+
+  mapSize = size;
+  header = (CHUNKMAP_HEADER *)ptr;
+  bitmap = (volatile uint32_t *)((uint8_t *)ptr + sizeof(CHUNKMAP_HEADER));
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+void ChunkMap::Close() {
+
+#ifdef WIN64
+  if (header) {
+    FlushViewOfFile(header, 0);
+    UnmapViewOfFile(header);
+  }
+  if (hMap) CloseHandle(hMap);
+  if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+  hMap = NULL;
+  hFile = INVALID_HANDLE_VALUE;
+#else
+  if (header) {
+    msync(header, mapSize, MS_SYNC);
+    munmap(header, mapSize);
+  }
+  if (fd >= 0) close(fd);
+  fd = -1;
+#endif
+  header = NULL;
+  bitmap = NULL;
+
+}
+
+// ----------------------------------------------------------------------------
+
+static inline uint64_t mix64(uint64_t z) {
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+
+}
+
+uint64_t ChunkMap::Permute(uint64_t i) {
+
+  // Balanced Feistel network on 2*halfBits bits, cycle walking keeps
+  // the result in [0,nbChunk) (the domain is less than 4*nbChunk)
+  uint64_t mask = (1ULL << halfBits) - 1;
+  uint64_t x = i;
+
+  do {
+    uint64_t l = x >> halfBits;
+    uint64_t r = x & mask;
+    for (int round = 0; round < FEISTEL_ROUNDS; round++) {
+      uint64_t t = l ^ (mix64(r + header->key + (round + 1) * 0x9E3779B97F4A7C15ULL) & mask);
+      l = r;
+      r = t;
+    }
+    x = (l << halfBits) | r;
+  } while (x >= nbChunk);
+
+  return x;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool ChunkMap::SetState(uint64_t chunk, uint32_t from, uint32_t to) {
+
+  // Lock free, the map can be shared by several processes
+  volatile uint32_t *w = bitmap + chunk / 16;
+  int shift = 2 * (chunk % 16);
+
+  while (true) {
+    uint32_t old = *w;
+    if (((old >> shift) & 3) != from)
+      return false;
+    uint32_t nw = (old & ~(3U << shift)) | (to << shift);
+#ifdef WIN64
+    if (InterlockedCompareExchange((volatile LONG *)w, (LONG)nw, (LONG)old) == (LONG)old)
+      return true;
+#else
+    if (__atomic_compare_exchange_n(w, &old, nw, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      return true;
+#endif
+  }
+
+}
+
+// ----------------------------------------------------------------------------
+
+uint64_t ChunkMap::ReleaseClaims() {
+
+  uint64_t nb = CountState(CHUNK_CLAIMED) + CountState(CHUNK_RETAKEN);
+  uint64_t nbWord = (nbChunk + 15) / 16;
+  for (uint64_t i = 0; i < nbWord; i++) {
+    uint32_t w = bitmap[i];
+    uint32_t d = w & (w >> 1) & 0x55555555U;
+    bitmap[i] = d | (d << 1);
+  }
+  return nb;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool ChunkMap::Next(uint64_t &chunk) {
+
+  // First pass claims free chunks, the second one (retake) claims again
+  // the chunks left unfinished by an interrupted process
+  while (pass < nbPass) {
+    while (cursor < nbChunk) {
+      uint64_t c = Permute((offset + cursor) % nbChunk);
+      cursor++;
+      if (pass == 0 && SetState(c, CHUNK_FREE, CHUNK_CLAIMED)) {
+        chunk = c;
+        return true;
+      }
+      if (pass == 1 && SetState(c, CHUNK_CLAIMED, CHUNK_RETAKEN)) {
+        chunk = c;
+        return true;
+      }
+    }
+    cursor = 0;
+    pass++;
+  }
+
+  return false;
+
+}
+
+void ChunkMap::Done(uint64_t chunk) {
+
+  volatile uint32_t *w = bitmap + chunk / 16;
+  uint32_t bits = CHUNK_DONE << (2 * (chunk % 16));
+#ifdef WIN64
+  InterlockedOr((volatile LONG *)w, (LONG)bits);
+  FlushViewOfFile((LPCVOID)w, sizeof(uint32_t));
+#else
+  __atomic_fetch_or(w, bits, __ATOMIC_ACQ_REL);
+  // Schedule the write back of the page holding this chunk
+  long pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t page = (uintptr_t)w & ~(uintptr_t)(pageSize - 1);
+  msync((void *)page, pageSize, MS_ASYNC);
+#endif
+
+}
+
+// ----------------------------------------------------------------------------
+
+void ChunkMap::GetRange(uint64_t chunk, Int &start, Int &end) {
+
+  start.Set(&chunkSize);
+  start.Mult(chunk);
+  start.Add(&ksStart);
+  end.Set(&start);
+  end.Add(&chunkSize);
+  end.SubOne();
+  if (end.IsGreater(&ksFinish))
+    end.Set(&ksFinish);
+
+}
+
+uint64_t ChunkMap::GetNbChunk() {
+  return nbChunk;
+}
+
+uint64_t ChunkMap::CountState(uint32_t state) {
+
+  // The padding of the last word is always free, do not count it
+  uint64_t nb = 0;
+  uint64_t nbWord = (nbChunk + 15) / 16;
+  for (uint64_t i = 0; i < nbWord; i++) {
+    uint32_t w = bitmap[i];
+    // Low bit of each pair set when the pair equals state
+    uint32_t x = ~(w ^ (state * 0x55555555U));
+    uint32_t d = x & (x >> 1) & 0x55555555U;
+    while (d) {
+      d &= d - 1;
+      nb++;
+    }
+  }
+  if (state == CHUNK_FREE)
+    nb -= nbWord * 16 - nbChunk;
+  return nb;
+
+}
+
+uint64_t ChunkMap::GetNbDone() {
+  return CountState(CHUNK_DONE);
+}
+
+uint64_t ChunkMap::GetNbClaimed() {
+  return CountState(CHUNK_CLAIMED) + CountState(CHUNK_RETAKEN);
+}
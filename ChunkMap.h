@@ -0,0 +1,112 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHUNKMAPH
+#define CHUNKMAPH
+
+#include <string>
+#include "Int.h"
+#ifdef WIN64
+#include <Windows.h>
+#endif
+
+// Chunk states, 2 bits per chunk in the map
+#define CHUNK_FREE    0
+#define CHUNK_CLAIMED 1
+#define CHUNK_RETAKEN 2
+#define CHUNK_DONE    3
+
+// Max number of chunks (the bitmap is then 1GB)
+#define CHUNK_MAX_COUNT (1ULL << 32)
+
+// Header of a chunk map file, followed by the bitmap (16 chunks per 32bit word)
+typedef struct {
+
+  char     magic[8];
+  uint32_t chunkBits;
+  uint32_t reserved;
+  uint64_t nbChunk;
+  uint64_t key;
+  uint8_t  ksStart[32];
+  uint8_t  ksFinish[32];
+  uint8_t  pad[32];
+
+} CHUNKMAP_HEADER;
+
+// [ksStart,ksFinish] split in 2^chunkBits chunks visited in a keyed
+// pseudo random order. The state of each chunk is kept in a memory mapped
+// file shared by every process working on the same range.
+class ChunkMap {
+
+public:
+
+  ChunkMap();
+  ~ChunkMap();
+
+  // Open (or create) the map of [ksStart,ksFinish], fails if the file
+  // was created for another range or chunk size. With retake, the chunks
+  // claimed by an interrupted process are searched again once no free
+  // chunk is left (no other process must be running on the map).
+  bool Open(std::string fileName, Int &ksStart, Int &ksFinish, int chunkBits, bool retake);
+  void Close();
+
+  // Free every claimed but unfinished chunk, for a process that owns the map
+  uint64_t ReleaseClaims();
+
+  // Claim the next chunk of the permutation
+  bool Next(uint64_t &chunk);
+  void Done(uint64_t chunk);
+  void GetRange(uint64_t chunk, Int &start, Int &end);
+
+  uint64_t GetNbChunk();
+  uint64_t GetNbDone();
+  uint64_t GetNbClaimed();
+
+  // Keyed Feistel permutation of [0,nbChunk)
+  uint64_t Permute(uint64_t i);
+
+private:
+
+  uint64_t CountState(uint32_t state);
+  bool SetState(uint64_t chunk, uint32_t from, uint32_t to);
+  bool Map(std::string fileName, uint64_t size);
+
+  std::string fileName;
+  CHUNKMAP_HEADER *header;
+  volatile uint32_t *bitmap;
+  uint64_t mapSize;
+  uint64_t nbChunk;
+  uint64_t cursor;
+  uint64_t offset;
+  int pass;
+  int nbPass;
+  int halfBits;
+
+  Int ksStart;
+  Int ksFinish;
+  Int chunkSize;
+
+#ifdef WIN64
+  HANDLE hFile;
+  HANDLE hMap;
+#else
+  int fd;
+#endif
+
+};
+
+#endif // CHUNKMAPH
@@ -0,0 +1,73 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPUTEENGINEH
+#define COMPUTEENGINEH
+
+#include <string>
+#include <vector>
+#include "SECP256k1.h"
+
+#define SEARCH_COMPRESSED 0
+#define SEARCH_UNCOMPRESSED 1
+#define SEARCH_BOTH 2
+
+static const char *searchModes[] = {"Compressed","Uncompressed","Compressed or Uncompressed"};
+
+typedef uint16_t address_t;
+typedef uint32_t addressl_t;
+
+// Candidate returned by an engine, the private key is
+// rangeStart + thId*stepThread + (launch-1)*stepSize + incr
+typedef struct {
+
+  uint32_t thId;
+  int16_t  incr;
+  int16_t  endo;
+  uint8_t  *hash;
+  bool mode;
+} ITEM;
+
+// Second level lookup
+typedef struct {
+  address_t sAddress;
+  std::vector<addressl_t> lAddresses;
+} LADDRESS;
+
+// Search backend: nbThread independent lanes, each one stepping
+// GetStepSize() keys per Launch() from the center point given by SetKeys()
+class ComputeEngine {
+
+public:
+
+  virtual ~ComputeEngine() {}
+
+  virtual void SetAddress(std::vector<address_t> addresses) = 0;
+  virtual void SetAddress(std::vector<LADDRESS> addresses,uint32_t totalAddress) = 0;
+  virtual bool SetKeys(Point *p) = 0;
+  virtual void SetSearchMode(int searchMode) = 0;
+  virtual void SetSearchType(int searchType) = 0;
+  virtual bool Launch(std::vector<ITEM> &addressFound,bool spinWait=false) = 0;
+  virtual int GetNbThread() = 0;
+  virtual int GetGroupSize() = 0;
+  virtual int GetStepSize() = 0;
+
+  std::string deviceName;
+
+};
+
+#endif // COMPUTEENGINEH
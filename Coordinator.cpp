@@ -0,0 +1,564 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef WIN64
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <process.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+#include "Coordinator.h"
+#include "Timer.h"
+#include <string.h>
+#include <time.h>
+#include <sstream>
+#include <algorithm>
+
+#define NET_TIMEOUT 10
+#define NET_RETRY 60
+#define NET_RETRY_DELAY 5000
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+static bool netInit() {
+
+#ifdef WIN64
+  static bool init = false;
+  if (!init) {
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+      fprintf(stderr, "[ERROR] WSAStartup failed\n");
+      return false;
+    }
+    init = true;
+  }
+#endif
+  return true;
+
+}
+
+static void setTimeout(SOCKET s) {
+
+#ifdef WIN64
+  DWORD tv = NET_TIMEOUT * 1000;
+#else
+  struct timeval tv;
+  tv.tv_sec = NET_TIMEOUT;
+  tv.tv_usec = 0;
+#endif
+  setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
+  setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof(tv));
+
+}
+
+static bool sendLine(SOCKET s, string line) {
+
+  line.append("\n");
+  size_t pos = 0;
+  while (pos < line.length()) {
+    int n = send(s, line.c_str() + pos, (int)(line.length() - pos), 0);
+    if (n <= 0)
+      return false;
+    pos += n;
+  }
+  return true;
+
+}
+
+static bool recvLine(SOCKET s, string &line) {
+
+  line.clear();
+  char c;
+  while (line.length() < 1024) {
+    if (recv(s, &c, 1, 0) != 1)
+      return false;
+    if (c == '\n')
+      return true;
+    if (c != '\r')
+      line.push_back(c);
+  }
+  return false;
+
+}
+
+// ----------------------------------------------------------------------------
+
+Coordinator::Coordinator(string bindAddress, int port, ChunkMap *chunks, int leaseTime, string outputFile, string token) {
+
+  this->bindAddress = bindAddress;
+  this->port = port;
+  this->token = token;
+  this->chunks = chunks;
+  this->leaseTime = leaseTime;
+  this->outputFile = outputFile;
+  this->noFreeChunk = false;
+
+}
+
+void Coordinator::Run() {
+
+  if (!netInit())
+    return;
+
+  SOCKET ls = socket(AF_INET, SOCK_STREAM, 0);
+  if (ls == INVALID_SOCKET) {
+    fprintf(stderr, "[ERROR] Coordinator: cannot create socket\n");
+    return;
+  }
+
+  int yes = 1;
+  setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, (const char *)&yes, sizeof(yes));
+
+  char portStr[16];
+  snprintf(portStr, sizeof(portStr), "%d", port);
+  struct addrinfo hints;
+  struct addrinfo *res = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+  bool ok = getaddrinfo(bindAddress.c_str(), portStr, &hints, &res) == 0 && res != NULL;
+  ok = ok && ::bind(ls, res->ai_addr, (int)res->ai_addrlen) == 0 && listen(ls, 64) == 0;
+  if (res)
+    freeaddrinfo(res);
+  if (!ok) {
+    fprintf(stderr, "[ERROR] Coordinator: cannot listen on %s:%d\n", bindAddress.c_str(), port);
+    closesocket(ls);
+    return;
+  }
+
+  printf("[coordinator] listening on %s:%d%s, chunks=%llu done=%llu lease=%ds\n", bindAddress.c_str(), port,
+    token.length() > 0 ? " (token)" : "",
+    (unsigned long long)chunks->GetNbChunk(), (unsigned long long)chunks->GetNbDone(), leaseTime);
+  fflush(stdout);
+
+  // Once every chunk is done, workers asking for work get END for a while
+  double tEnd = 0;
+
+  while (true) {
+
+    Expire();
+
+    if (noFreeChunk && leases.empty() && requeue.empty()) {
+      if (tEnd == 0) {
+        printf("[coordinator] all chunks done\n");
+        fflush(stdout);
+        tEnd = Timer::get_tick() + 2 * COORDINATOR_WAIT;
+      } else if (Timer::get_tick() > tEnd) {
+        break;
+      }
+    }
+
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(ls, &fds);
+    struct timeval tv;
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    if (select((int)ls + 1, &fds, NULL, NULL, &tv) <= 0)
+      continue;
+
+    SOCKET s = accept(ls, NULL, NULL);
+    if (s == INVALID_SOCKET)
+      continue;
+    setTimeout(s);
+
+    string request;
+    if (recvLine(s, request))
+      sendLine(s, Handle(request));
+    closesocket(s);
+
+  }
+
+  closesocket(ls);
+
+}
+
+// ----------------------------------------------------------------------------
+
+void Coordinator::Expire() {
+
+  double now = Timer::get_tick();
+  std::map<uint64_t, LEASE>::iterator it = leases.begin();
+  while (it != leases.end()) {
+    if (it->second.expire < now) {
+      printf("[coordinator] lease of chunk #%llu (%s) expired\n", (unsigned long long)it->first, it->second.worker.c_str());
+      fflush(stdout);
+      requeue.push_back(it->first);
+      it = leases.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+}
+
+string Coordinator::Handle(string request) {
+
+  istringstream ss(request);
+  string cmd;
+  char tmp[256];
+  ss >> cmd;
+  double now = Timer::get_tick();
+
+  // Shared token of the workers
+  if (cmd == "AUTH") {
+    string t;
+    ss >> t >> cmd;
+    if (t != token)
+      return "ERR authentication failed";
+  } else if (token.length() > 0) {
+    return "ERR authentication failed";
+  }
+
+  if (cmd == "LEASE") {
+
+    string name, digest;
+    ss >> name >> digest;
+    if (ss.fail())
+      return "ERR invalid request";
+
+    // All workers must search the same targets
+    if (targetDigest.length() == 0)
+      targetDigest = digest;
+    if (digest != targetDigest)
+      return "ERR target list differs from the other workers";
+
+    uint64_t chunk;
+    bool ok = false;
+    if (!requeue.empty()) {
+      chunk = requeue.front();
+      requeue.pop_front();
+      ok = true;
+    } else if (!noFreeChunk) {
+      ok = chunks->Next(chunk);
+      noFreeChunk = !ok;
+    }
+
+    if (!ok) {
+      if (leases.empty())
+        return "END";
+      snprintf(tmp, sizeof(tmp), "WAIT %d", COORDINATOR_WAIT);
+      return string(tmp);
+    }
+
+    LEASE l;
+    l.worker = name;
+    l.expire = now + leaseTime;
+    leases[chunk] = l;
+
+    Int start;
+    Int end;
+    chunks->GetRange(chunk, start, end);
+    printf("[coordinator] chunk #%llu leased to %s\n", (unsigned long long)chunk, name.c_str());
+    fflush(stdout);
+    snprintf(tmp, sizeof(tmp), "RANGE %llu %s %s %d", (unsigned long long)chunk,
+      start.GetBase16().c_str(), end.GetBase16().c_str(), leaseTime);
+    return string(tmp);
+
+  } else if (cmd == "RENEW") {
+
+    unsigned long long chunk;
+    ss >> chunk;
+    if (ss.fail())
+      return "ERR invalid request";
+
+    std::map<uint64_t, LEASE>::iterator it = leases.find(chunk);
+    if (it != leases.end()) {
+      it->second.expire = now + leaseTime;
+      return "OK";
+    }
+
+    // Expired but not issued again yet, the worker keeps it
+    for (std::deque<uint64_t>::iterator q = requeue.begin(); q != requeue.end(); ++q) {
+      if (*q == chunk) {
+        requeue.erase(q);
+        LEASE l;
+        l.worker = "renewed";
+        l.expire = now + leaseTime;
+        leases[chunk] = l;
+        return "OK";
+      }
+    }
+    return "ERR lease expired";
+
+  } else if (cmd == "DONE") {
+
+    unsigned long long chunk;
+    ss >> chunk;
+    if (ss.fail() || chunk >= chunks->GetNbChunk())
+      return "ERR invalid request";
+
+    // A late DONE of an expired lease is still a finished chunk
+    leases.erase(chunk);
+    for (std::deque<uint64_t>::iterator q = requeue.begin(); q != requeue.end(); ++q) {
+      if (*q == chunk) {
+        requeue.erase(q);
+        break;
+      }
+    }
+    chunks->Done(chunk);
+    printf("[coordinator] chunk #%llu done (%llu/%llu)\n", chunk,
+      (unsigned long long)chunks->GetNbDone(), (unsigned long long)chunks->GetNbChunk());
+    fflush(stdout);
+    return "OK";
+
+  } else if (cmd == "FOUND") {
+
+    string name, addr, wif, hex;
+    ss >> name >> addr >> wif >> hex;
+    if (ss.fail())
+      return "ERR invalid request";
+
+    time_t t = time(0);
+    char timestamp[64];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&t));
+
+    FILE *f = stdout;
+    if (outputFile.length() > 0) {
+      f = fopen(outputFile.c_str(), "a");
+      if (f == NULL) {
+        fprintf(stderr, "[ERROR] Coordinator: cannot open %s for writing\n", outputFile.c_str());
+        f = stdout;
+      }
+    }
+    fprintf(f, "\n=== FOUND KEY ===\n");
+    fprintf(f, "Timestamp: %s\n", timestamp);
+    fprintf(f, "Worker: %s\n", name.c_str());
+    fprintf(f, "Public Address: %s\n", addr.c_str());
+    fprintf(f, "Private Key (WIF): %s\n", wif.c_str());
+    fprintf(f, "Private Key (HEX): 0x%s\n", hex.c_str());
+    fprintf(f, "=================\n");
+    if (f != stdout)
+      fclose(f);
+    printf("[coordinator] %s found %s\n", name.c_str(), addr.c_str());
+    fflush(stdout);
+    return "OK";
+
+  }
+
+  return "ERR unknown request";
+
+}
+
+// ----------------------------------------------------------------------------
+
+WorkClient::WorkClient(string host, int port, string targetDigest, string token) {
+
+  this->host = host;
+  this->port = port;
+  this->targetDigest = targetDigest;
+  this->token = token;
+  renewing = false;
+  foundStop = false;
+  netInit();
+
+  char hostName[256];
+  if (gethostname(hostName, sizeof(hostName)) != 0)
+    strcpy(hostName, "worker");
+  hostName[sizeof(hostName) - 1] = 0;
+  char suffix[16];
+  snprintf(suffix, sizeof(suffix), ".%04x", Timer::getSeed32() & 0xFFFF);
+  name = string(hostName) + suffix;
+
+  foundThread = std::thread(&WorkClient::SendFound, this);
+
+}
+
+WorkClient::~WorkClient() {
+
+  {
+    std::lock_guard<std::mutex> lock(foundMutex);
+    foundStop = true;
+  }
+  foundCond.notify_one();
+  foundThread.join();
+  StopRenew();
+
+}
+
+bool WorkClient::Request(string request, string &reply) {
+
+  std::lock_guard<std::mutex> lock(requestMutex);
+
+  if (token.length() > 0)
+    request = "AUTH " + token + " " + request;
+
+  char portStr[16];
+  snprintf(portStr, sizeof(portStr), "%d", port);
+
+  for (int retry = 0; retry < NET_RETRY; retry++) {
+
+    if (retry > 0) {
+      printf("\n[worker] coordinator %s:%d unreachable, retrying (%d/%d)\n", host.c_str(), port, retry, NET_RETRY - 1);
+      fflush(stdout);
+      Timer::SleepMillis(NET_RETRY_DELAY);
+    }
+
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), portStr, &hints, &res) != 0 || res == NULL)
+      continue;
+
+    SOCKET s = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (s == INVALID_SOCKET) {
+      freeaddrinfo(res);
+      continue;
+    }
+    setTimeout(s);
+
+    bool ok = connect(s, res->ai_addr, (int)res->ai_addrlen) == 0;
+    freeaddrinfo(res);
+    ok = ok && sendLine(s, request) && recvLine(s, reply);
+    closesocket(s);
+
+    if (ok)
+      return true;
+
+  }
+
+  fprintf(stderr, "[ERROR] Worker: coordinator %s:%d unreachable\n", host.c_str(), port);
+  return false;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool WorkClient::Lease(uint64_t &chunk, Int &start, Int &end) {
+
+  while (true) {
+
+    string reply;
+    if (!Request("LEASE " + name + " " + targetDigest, reply))
+      return false;
+
+    istringstream ss(reply);
+    string cmd;
+    ss >> cmd;
+
+    if (cmd == "RANGE") {
+      unsigned long long c;
+      string s, e;
+      int leaseTime;
+      ss >> c >> s >> e >> leaseTime;
+      if (ss.fail() || leaseTime <= 0) {
+        fprintf(stderr, "[ERROR] Worker: invalid reply \"%s\"\n", reply.c_str());
+        return false;
+      }
+      chunk = c;
+      start.SetBase16((char *)s.c_str());
+      end.SetBase16((char *)e.c_str());
+      StartRenew(chunk, leaseTime);
+      return true;
+    } else if (cmd == "WAIT") {
+      int wait = COORDINATOR_WAIT;
+      ss >> wait;
+      Timer::SleepMillis(1000 * (uint32_t)std::max(1, wait));
+    } else if (cmd == "END") {
+      return false;
+    } else {
+      fprintf(stderr, "[ERROR] Worker: %s\n", reply.c_str());
+      return false;
+    }
+
+  }
+
+}
+
+bool WorkClient::Done(uint64_t chunk) {
+
+  StopRenew();
+  string reply;
+  return Request("DONE " + std::to_string(chunk), reply) && reply == "OK";
+
+}
+
+void WorkClient::Found(string addr, string wif, string hex) {
+
+  {
+    std::lock_guard<std::mutex> lock(foundMutex);
+    foundQueue.push_back("FOUND " + name + " " + addr + " " + wif + " " + hex);
+  }
+  foundCond.notify_one();
+
+}
+
+// Found keys are sent from this thread, the search threads do not wait
+// for an unreachable coordinator. Exits once stopped and the queue empty.
+void WorkClient::SendFound() {
+
+  std::unique_lock<std::mutex> lock(foundMutex);
+  while (true) {
+    foundCond.wait(lock, [this]() { return foundStop || !foundQueue.empty(); });
+    if (foundQueue.empty())
+      break;
+    string request = foundQueue.front();
+    foundQueue.pop_front();
+    lock.unlock();
+    string reply;
+    if (!Request(request, reply) || reply != "OK")
+      fprintf(stderr, "[ERROR] Worker: found key not reported to the coordinator (%s)\n", reply.c_str());
+    lock.lock();
+  }
+
+}
+
+// ----------------------------------------------------------------------------
+
+void WorkClient::StartRenew(uint64_t chunk, int leaseTime) {
+
+  StopRenew();
+  renewing = true;
+
+  // Renew 3 times per lease period
+  renewThread = std::thread([this, chunk, leaseTime]() {
+    double period = std::max(1.0, leaseTime / 3.0);
+    double t0 = Timer::get_tick();
+    while (renewing) {
+      Timer::SleepMillis(100);
+      if (renewing && Timer::get_tick() - t0 >= period) {
+        string reply;
+        Request("RENEW " + std::to_string(chunk), reply);
+        t0 = Timer::get_tick();
+      }
+    }
+  });
+
+}
+
+void WorkClient::StopRenew() {
+
+  renewing = false;
+  if (renewThread.joinable())
+    renewThread.join();
+
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COORDINATORH
+#define COORDINATORH
+
+#include <string>
+#include <map>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "ChunkMap.h"
+
+// Work unit protocol, one text request and one text reply per connection:
+//   LEASE name digest          -> RANGE chunk start end leaseSec | WAIT sec | END | ERR msg
+//   RENEW chunk                -> OK | ERR msg
+//   DONE chunk                 -> OK
+//   FOUND name addr wif hex    -> OK
+// With a shared token, requests are prefixed by "AUTH token " and the
+// coordinator answers ERR to the others. The protocol is not encrypted.
+
+#define COORDINATOR_WAIT 10
+
+typedef struct {
+
+  std::string worker;
+  double expire;
+
+} LEASE;
+
+// Default listening address of the coordinator (this host only)
+#define COORDINATOR_BIND "127.0.0.1"
+
+// Leases the chunks of a ChunkMap to worker processes, a lease that is
+// not renewed before its expiry is issued again to another worker
+class Coordinator {
+
+public:
+
+  Coordinator(std::string bindAddress, int port, ChunkMap *chunks, int leaseTime, std::string outputFile, std::string token);
+  void Run();
+
+private:
+
+  std::string Handle(std::string request);
+  void Expire();
+
+  std::string bindAddress;
+  int port;
+  std::string token;
+  ChunkMap *chunks;
+  int leaseTime;
+  std::string outputFile;
+  std::string targetDigest;
+  std::map<uint64_t, LEASE> leases;
+  std::deque<uint64_t> requeue;
+  bool noFreeChunk;
+
+};
+
+// Worker side of the protocol, requests are retried while the coordinator
+// is unreachable (restart), a thread renews the current lease and another
+// one sends the found keys
+class WorkClient {
+
+public:
+
+  // The worker is named hostname.random in the coordinator logs
+  WorkClient(std::string host, int port, std::string targetDigest, std::string token);
+  ~WorkClient();
+
+  // false when the coordinator has no more work
+  bool Lease(uint64_t &chunk, Int &start, Int &end);
+  bool Done(uint64_t chunk);
+
+  // Queue a found key, does not wait for the coordinator. The queue is
+  // sent before the destructor returns.
+  void Found(std::string addr, std::string wif, std::string hex);
+
+private:
+
+  bool Request(std::string request, std::string &reply);
+  void StartRenew(uint64_t chunk, int leaseTime);
+  void StopRenew();
+  void SendFound();
+
+  std::string host;
+  int port;
+  std::string name;
+  std::string targetDigest;
+  std::string token;
+
+  std::thread renewThread;
+  std::atomic<bool> renewing;
+  std::mutex requestMutex;
+
+  std::thread foundThread;
+  std::deque<std::string> foundQueue;
+  std::mutex foundMutex;
+  std::condition_variable foundCond;
+  bool foundStop;
+
+};
+
+#endif // COORDINATORH
@@ -421,8 +421,31 @@ void GPUEngine::SetSearchType(int searchType) {
 
 // ---------------------------------------------------------------------------------------
 
+// The pinned buffer is released after an upload, it is allocated again
+// when the targets are reloaded
+bool GPUEngine::AllocAddressPinned() {
+
+    if (inputAddressPinned)
+        return true;
+    cudaError_t err = cudaHostAlloc(&inputAddressPinned, _64K * 2, cudaHostAllocWriteCombined | cudaHostAllocMapped);
+    if (err != cudaSuccess) {
+        printf("GPUEngine: Allocate address pinned memory: %s\n", cudaGetErrorString(err));
+        inputAddressPinned = NULL;
+        return false;
+    }
+    return true;
+
+}
+
 void GPUEngine::SetAddress(std::vector<address_t> addresses) {
 
+    if (!AllocAddressPinned())
+        return;
+    if (inputAddressLookUp) {
+        cudaFree(inputAddressLookUp);
+        inputAddressLookUp = NULL;
+    }
+
     memset(inputAddressPinned, 0, _64K * 2);
     for (int i = 0;i < (int)addresses.size();i++)
         inputAddressPinned[addresses[i]] = 1;
@@ -469,7 +492,15 @@ void GPUEngine::SetPattern(const char* pattern) {
 
 void GPUEngine::SetAddress(std::vector<LADDRESS> addresses, uint32_t totalAddress) {
 
-    // Allocate memory for the second level of lookup tables
+    if (!AllocAddressPinned())
+        return;
+
+    // Allocate memory for the second level of lookup tables, cudaFree waits
+    // for the kernel using the previous ones
+    if (inputAddressLookUp) {
+        cudaFree(inputAddressLookUp);
+        inputAddressLookUp = NULL;
+    }
     cudaError_t err = cudaMalloc((void**)&inputAddressLookUp, (_64K + totalAddress) * 4);
     if (err != cudaSuccess) {
         printf("GPUEngine: Allocate address lookup memory: %s\n", cudaGetErrorString(err));
@@ -684,44 +715,6 @@ std::string toHex(unsigned char* data, int length) {
 }
 
 
-
-// ---------------------------------------------------------------------------------------
-
-void GPUEngine::FreeGPUEngine() {  //free gpu for Pause function
-
-    // Ensure all operations have completed before freeing memory
-    cudaDeviceSynchronize();
-
-    // Free device memory
-    cudaFree(inputKey);
-    cudaFree(inputAddress);
-    if (inputAddressLookUp) {
-        cudaFree(inputAddressLookUp);  // Free the lookup table memory if allocated
-    }
-    cudaFree(outputBuffer);
-
-    // Free pinned memory
-    cudaFreeHost(inputAddressPinned);
-    cudaFreeHost(inputKeyPinned);
-    cudaFreeHost(outputBufferPinned);
-
-    // Reset the pointers to prevent dangling references
-    inputAddressPinned = NULL;
-    inputKeyPinned = NULL;
-    outputBufferPinned = NULL;
-    inputAddressLookUpPinned = NULL;
-    inputAddressLookUp = NULL;
-
-    cudaError_t err = cudaGetLastError();
-    if (err != cudaSuccess) {
-        printf("GPUEngine: Error freeing memory: %s\n", cudaGetErrorString(err));
-    }
-
-    cudaDeviceReset();
-
-}
-
-
 bool GPUEngine::CheckHash(uint8_t* h, vector<ITEM>& found, int tid, int incr, int endo, int* nbOK) {
 
     return true;
@@ -21,10 +21,7 @@
 #include <vector>
 #include <unordered_map>
 #include "../SECP256k1.h"
-
-#define SEARCH_COMPRESSED 0
-#define SEARCH_UNCOMPRESSED 1
-#define SEARCH_BOTH 2
+#include "../ComputeEngine.h"
 
 
 // Number of thread per block
@@ -33,36 +30,14 @@
 #define ITEM_SIZE32 (ITEM_SIZE/4)
 #define _64K 65536
 
-static const char *searchModes[] = {"Compressed","Uncompressed","Compressed or Uncompressed"};
-
 // Number of key per thread (must be a multiple of GRP_SIZE) per kernel call
 
-
-typedef uint16_t address_t;
-typedef uint32_t addressl_t;
-
-typedef struct {
-
-  uint32_t thId;
-  int16_t  incr;
-  int16_t  endo;
-  uint8_t  *hash;
-  bool mode;
-} ITEM;
-
-// Second level lookup
-typedef struct {
-  address_t sAddress;
-  std::vector<addressl_t> lAddresses;
-} LADDRESS;
-
-class GPUEngine {
+class GPUEngine : public ComputeEngine {
 
 public:
 
   GPUEngine(int gpuId, uint32_t maxFound, int batchSize);
   ~GPUEngine();
-  void FreeGPUEngine();
   void SetAddress(std::vector<address_t> addresses);
   void SetAddress(std::vector<LADDRESS> addresses,uint32_t totalAddress);
   bool SetKeys(Point *p);
@@ -75,7 +50,6 @@ public:
   int GetStepSize();
 
   bool Check(Secp256K1 *secp);
-  std::string deviceName;
 
   static void PrintCudaInfo();
   static void GenerateCode(Secp256K1 *secp, int size);
@@ -83,6 +57,7 @@ public:
 private:
 
   bool callKernel(int batchSize);
+  bool AllocAddressPinned();
   static void ComputeIndex(std::vector<int> &s, int depth, int n);
   static void Browse(FILE *f,int depth, int max, int s);
   bool CheckHash(uint8_t *h, std::vector<ITEM>& found, int tid, int incr, int endo, int *ok);
@@ -701,7 +701,8 @@ void Int::ShiftL(uint32_t n) {
     uint32_t nb64 = n/64;
     uint32_t nb   = n%64;
     for(uint32_t i=0;i<nb64;i++) ShiftL64Bit();
-	  shiftL((unsigned char)nb, bits64);
+	  // __shiftleft128/__shiftright128 are undefined for a null shift
+	  if(nb) shiftL((unsigned char)nb, bits64);
   }
   
 }
@@ -747,7 +748,8 @@ void Int::ShiftR(uint32_t n) {
     uint32_t nb64 = n/64;
     uint32_t nb   = n%64;
     for(uint32_t i=0;i<nb64;i++) ShiftR64Bit();
-	  shiftR((unsigned char)nb, bits64);
+	  // __shiftleft128/__shiftright128 are undefined for a null shift
+	  if(nb) shiftR((unsigned char)nb, bits64);
   }
   
 }
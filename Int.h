@@ -249,6 +249,7 @@ static uint64_t inline __rdtsc() {
 #define __shiftleft128(a,b,n) ((b)<<(n))|((a)>>(64-(n)))
 
 
+// Plain adc/sbb, ADX is not needed
 #define _subborrow_u64(a,b,c,d) __builtin_ia32_sbb_u64(a,b,c,(long long unsigned int*)d);
 #define _addcarry_u64(a,b,c,d) __builtin_ia32_addcarryx_u64(a,b,c,(long long unsigned int*)d);
 #define _byteswap_uint64 __builtin_bswap64
@@ -0,0 +1,605 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PatternMatcher.h"
+#include "Wildcard.h"
+#include "Random.h"
+#include "Timer.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+static const char *b58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+// Characters of the transition rows, and their row index
+static const char *patternChars = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz0l";
+
+static const int8_t patternCharMap[] = {
+  -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+  -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+  -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+  58, 0, 1, 2, 3, 4, 5, 6,  7, 8,-1,-1,-1,-1,-1,-1,
+  -1, 9,10,11,12,13,14,15, 16,-1,17,18,19,20,21,-1,
+  22,23,24,25,26,27,28,29, 30,31,32,-1,-1,-1,-1,-1,
+  -1,33,34,35,36,37,38,39, 40,41,42,43,59,44,45,46,
+  47,48,49,50,51,52,53,54, 55,56,57,-1,-1,-1,-1,-1,
+};
+
+static inline int charIndex(char c) {
+  return ((uint8_t)c < 128) ? patternCharMap[(uint8_t)c] : -1;
+}
+
+// Set of active NFA nodes, on the stack until PATTERN_LOCAL_STATE
+class StateSet {
+
+public:
+
+  StateSet() {
+    s = local;
+    n = 0;
+    cap = PATTERN_LOCAL_STATE;
+  }
+
+  inline void Push(uint32_t node) {
+    if (n == cap) Grow();
+    s[n++] = node;
+  }
+
+  inline bool Contain(uint32_t node) {
+    for (uint32_t i = 0; i < n; i++)
+      if (s[i] == node) return true;
+    return false;
+  }
+
+  uint32_t *s;
+  uint32_t n;
+
+private:
+
+  void Grow() {
+    if (s == local)
+      heap.assign(local, local + n);
+    heap.resize((size_t)cap * 2);
+    s = heap.data();
+    cap *= 2;
+  }
+
+  uint32_t cap;
+  uint32_t local[PATTERN_LOCAL_STATE];
+  vector<uint32_t> heap;
+
+};
+
+// ----------------------------------------------------------------------------
+
+PatternMatcher::PatternMatcher() {
+  Clear();
+}
+
+void PatternMatcher::Clear() {
+
+  nbPattern = 0;
+  patterns.clear();
+  dfaNext.clear();
+  dfaAccept.clear();
+  dfaSparse.clear();
+  dfaStart = PATTERN_NONE;
+  acceptAll = -1;
+  nfaNext.clear();
+  nfaNodes.clear();
+
+}
+
+uint32_t PatternMatcher::GetSize() {
+  return nbPattern;
+}
+
+uint32_t PatternMatcher::GetNbState() {
+  return (uint32_t)(dfaAccept.size() + dfaSparse.size() + nfaNodes.size());
+}
+
+void PatternMatcher::Add(string pattern) {
+
+  patterns.push_back(pattern);
+  nbPattern++;
+
+}
+
+uint32_t PatternMatcher::TrieChild(PATTERN_TRIE &t, uint32_t node, char c) {
+
+  for (auto &e : t.children[node])
+    if (e.first == c)
+      return e.second;
+  return PATTERN_NONE;
+
+}
+
+void PatternMatcher::TrieAdd(PATTERN_TRIE &t, const string &pattern, int32_t index) {
+
+  if (t.accept.empty()) {
+    t.children.emplace_back();
+    t.accept.push_back(-1);
+  }
+
+  // "**" is "*"
+  uint32_t node = 0;
+  for (size_t i = 0; i < pattern.length(); i++) {
+    if (pattern[i] == '*' && i > 0 && pattern[i - 1] == '*')
+      continue;
+    uint32_t next = TrieChild(t, node, pattern[i]);
+    if (next == PATTERN_NONE) {
+      next = (uint32_t)t.accept.size();
+      t.children.emplace_back();
+      t.accept.push_back(-1);
+      t.children[node].push_back(make_pair(pattern[i], next));
+    }
+    node = next;
+  }
+
+  if (t.accept[node] < 0)
+    t.accept[node] = index;
+
+}
+
+void PatternMatcher::Build() {
+
+  dfaNext.clear();
+  dfaAccept.clear();
+  dfaSparse.clear();
+  dfaStart = PATTERN_NONE;
+  acceptAll = -1;
+  nfaNext.clear();
+  nfaNodes.clear();
+
+  // A '*' before the end goes to the NFA
+  PATTERN_TRIE dfa;
+  PATTERN_TRIE nfa;
+  for (uint32_t i = 0; i < nbPattern; i++) {
+    size_t star = patterns[i].find('*');
+    if (star == string::npos || patterns[i].find_first_not_of('*', star) == string::npos)
+      TrieAdd(dfa, patterns[i], (int32_t)i);
+    else
+      TrieAdd(nfa, patterns[i], (int32_t)i);
+  }
+
+  if (!dfa.accept.empty() && !BuildDFA(dfa)) {
+    // Too many states, everything in the NFA
+    dfaNext.clear();
+    dfaAccept.clear();
+    dfaSparse.clear();
+    dfaStart = PATTERN_NONE;
+    nfa = PATTERN_TRIE();
+    for (uint32_t i = 0; i < nbPattern; i++)
+      TrieAdd(nfa, patterns[i], (int32_t)i);
+  }
+  if (!nfa.accept.empty())
+    BuildNFA(nfa);
+
+}
+
+// Subset construction, a DFA state is a set of trie nodes of the same depth
+bool PatternMatcher::BuildDFA(PATTERN_TRIE &t) {
+
+  // A node with a '*' child matches any rest (the '*' is the last character)
+  vector<int32_t> rest(t.accept.size(), -1);
+  for (uint32_t n = 0; n < (uint32_t)t.accept.size(); n++) {
+    uint32_t s = TrieChild(t, n, '*');
+    if (s != PATTERN_NONE)
+      rest[n] = t.accept[s];
+  }
+  if (rest[0] >= 0) {
+    acceptAll = rest[0];
+    return true;
+  }
+
+  // Transitions (character, state or PATTERN_ACCEPT|pattern) of the states
+  map<vector<uint32_t>, uint32_t> ids;
+  vector<vector<uint32_t>> sets;
+  vector<vector<pair<uint8_t, uint32_t>>> trans;
+  vector<int32_t> accept;
+  sets.push_back(vector<uint32_t>(1, 0));
+  ids[sets[0]] = 0;
+
+  vector<uint32_t> next;
+  for (size_t s = 0; s < sets.size(); s++) {
+
+    if (sets.size() > PATTERN_MAX_STATE)
+      return false;
+
+    vector<uint32_t> cur;
+    cur.swap(sets[s]);
+    int32_t acc = -1;
+    for (uint32_t n : cur)
+      if (acc < 0)
+        acc = t.accept[n];
+    accept.push_back(acc);
+    trans.emplace_back();
+
+    for (int c = 0; c < PATTERN_NB_CHAR; c++) {
+
+      next.clear();
+      int32_t match = -1;
+      for (uint32_t n : cur) {
+        uint32_t a = TrieChild(t, n, patternChars[c]);
+        uint32_t b = TrieChild(t, n, '?');
+        if (a != PATTERN_NONE) {
+          next.push_back(a);
+          if (match < 0) match = rest[a];
+        }
+        if (b != PATTERN_NONE) {
+          next.push_back(b);
+          if (match < 0) match = rest[b];
+        }
+      }
+
+      if (match >= 0) {
+        trans[s].push_back(make_pair((uint8_t)c, PATTERN_ACCEPT | (uint32_t)match));
+        continue;
+      }
+      if (next.empty())
+        continue;
+      std::sort(next.begin(), next.end());
+      next.erase(std::unique(next.begin(), next.end()), next.end());
+      auto it = ids.find(next);
+      if (it == ids.end()) {
+        it = ids.insert(make_pair(next, (uint32_t)sets.size())).first;
+        sets.push_back(next);
+      }
+      trans[s].push_back(make_pair((uint8_t)c, it->second));
+
+    }
+
+  }
+
+  // Dense rows for the branching states, lists for the others
+  uint32_t nbState = (uint32_t)trans.size();
+  vector<uint32_t> ref(nbState);
+  uint32_t nbDense = 0;
+  uint32_t nbSparse = 0;
+  for (uint32_t s = 0; s < nbState; s++)
+    ref[s] = (trans[s].size() > PATTERN_NB_SPARSE) ? nbDense++ : PATTERN_SPARSE | nbSparse++;
+
+  dfaNext.assign((size_t)nbDense * PATTERN_NB_CHAR, PATTERN_NONE);
+  dfaAccept.resize(nbDense);
+  dfaSparse.resize(nbSparse);
+  for (uint32_t s = 0; s < nbState; s++) {
+    uint32_t r = ref[s];
+    PATTERN_SPARSE_STATE *sp = (r & PATTERN_SPARSE) ? &dfaSparse[r & ~PATTERN_SPARSE] : NULL;
+    if (sp) {
+      memset(sp, 0, sizeof(PATTERN_SPARSE_STATE));
+      sp->accept = accept[s];
+    } else {
+      dfaAccept[r] = accept[s];
+    }
+    for (auto &e : trans[s]) {
+      uint32_t to = (e.second & PATTERN_ACCEPT) ? e.second : ref[e.second];
+      if (sp) {
+        sp->c[sp->nb] = e.first;
+        sp->next[sp->nb++] = to;
+      } else {
+        dfaNext[(size_t)r * PATTERN_NB_CHAR + e.first] = to;
+      }
+    }
+  }
+  dfaStart = ref[0];
+
+  return true;
+
+}
+
+void PatternMatcher::BuildNFA(PATTERN_TRIE &t) {
+
+  uint32_t nbNode = (uint32_t)t.accept.size();
+  nfaNext.assign((size_t)nbNode * PATTERN_NB_CHAR, PATTERN_NONE);
+  nfaNodes.resize(nbNode);
+  for (uint32_t n = 0; n < nbNode; n++) {
+    PATTERN_NODE &node = nfaNodes[n];
+    node.anyChild = PATTERN_NONE;
+    node.starChild = PATTERN_NONE;
+    node.accept = t.accept[n];
+  }
+  for (uint32_t n = 0; n < nbNode; n++) {
+    for (auto &e : t.children[n]) {
+      if (e.first == '?') {
+        nfaNodes[n].anyChild = e.second;
+      } else if (e.first == '*') {
+        nfaNodes[n].starChild = e.second;
+      } else if (charIndex(e.first) >= 0) {
+        nfaNext[(size_t)n * PATTERN_NB_CHAR + charIndex(e.first)] = e.second;
+      }
+    }
+  }
+
+}
+
+// ----------------------------------------------------------------------------
+
+int32_t PatternMatcher::Match(const char *str) {
+
+  if (nbPattern < PATTERN_MIN_TRIE) {
+    for (uint32_t i = 0; i < nbPattern; i++)
+      if (Wildcard::match(str, patterns[i].c_str()))
+        return (int32_t)i;
+    return -1;
+  }
+
+  int32_t id = MatchDFA(str);
+  if (id < 0 && nfaNodes.size() > 0)
+    id = MatchNFA(str);
+  return id;
+
+}
+
+int32_t PatternMatcher::MatchDFA(const char *str) {
+
+  if (acceptAll >= 0)
+    return acceptAll;
+
+  uint32_t s = dfaStart;
+  if (s == PATTERN_NONE)
+    return -1;
+  for (const char *p = str; *p; p++) {
+    int c = charIndex(*p);
+    if (c < 0)
+      return -1;
+    if (s & PATTERN_SPARSE) {
+      const PATTERN_SPARSE_STATE &sp = dfaSparse[s & ~PATTERN_SPARSE];
+      s = PATTERN_NONE;
+      for (int i = 0; i < sp.nb; i++)
+        if (sp.c[i] == c)
+          s = sp.next[i];
+    } else {
+      s = dfaNext[(size_t)s * PATTERN_NB_CHAR + c];
+    }
+    if (s == PATTERN_NONE)
+      return -1;
+    if (s & PATTERN_ACCEPT)
+      return (int32_t)(s & ~PATTERN_ACCEPT);
+  }
+  return (s & PATTERN_SPARSE) ? dfaSparse[s & ~PATTERN_SPARSE].accept : dfaAccept[s];
+
+}
+
+int32_t PatternMatcher::MatchNFA(const char *str) {
+
+  // A live '*' node stays live (it matches any character) and is kept in
+  // stars, the other nodes have a single parent so the sets have no
+  // duplicate
+  StateSet a;
+  StateSet b;
+  StateSet stars;
+  StateSet *cur = &a;
+  StateSet *next = &b;
+
+  // A node is entered with its '*' child (empty sequence), an accepting
+  // '*' matches the rest of the string
+#define ENTER(set, n) {                               \
+  (set)->Push(n);                                     \
+  uint32_t s = nfaNodes[n].starChild;                 \
+  if (s != PATTERN_NONE) {                            \
+    if (nfaNodes[s].accept >= 0)                      \
+      return nfaNodes[s].accept;                      \
+    if (!stars.Contain(s))                            \
+      stars.Push(s);                                  \
+  } }
+
+  ENTER(cur, 0);
+
+  for (const char *p = str; *p; p++) {
+
+    int c = charIndex(*p);
+    uint32_t nbStar = stars.n;
+    next->n = 0;
+    for (uint32_t i = 0; i < cur->n + nbStar; i++) {
+      uint32_t n = (i < cur->n) ? cur->s[i] : stars.s[i - cur->n];
+      if (c >= 0) {
+        uint32_t to = nfaNext[(size_t)n * PATTERN_NB_CHAR + c];
+        if (to != PATTERN_NONE)
+          ENTER(next, to);
+      }
+      // '?' does not match '.' (Wildcard::match)
+      uint32_t any = nfaNodes[n].anyChild;
+      if (any != PATTERN_NONE && *p != '.')
+        ENTER(next, any);
+    }
+    if (next->n == 0 && stars.n == 0)
+      return -1;
+    std::swap(cur, next);
+
+  }
+
+#undef ENTER
+
+  for (uint32_t i = 0; i < cur->n; i++)
+    if (nfaNodes[cur->s[i]].accept >= 0)
+      return nfaNodes[cur->s[i]].accept;
+  return -1;
+
+}
+
+// ----------------------------------------------------------------------------
+
+static string randomAddress(Secp256K1 *secp) {
+
+  unsigned char h[20];
+  for (int j = 0; j < 20; j += 4) {
+    uint32_t r = rndl();
+    memcpy(h + j, &r, 4);
+  }
+  return secp->GetAddress(P2PKH, true, h);
+
+}
+
+bool PatternMatcher::Check(Secp256K1 *secp) {
+
+  const int nbAddress = 4096;
+  const int nbPat = 1000;
+
+  printf("PatternMatcher: Check %d patterns: ", nbPat);
+
+  vector<string> addresses(nbAddress);
+  for (int i = 0; i < nbAddress; i++)
+    addresses[i] = randomAddress(secp);
+
+  // Patterns taken from the first addresses (prefixes, '?', '*' and whole
+  // addresses), with the equivalent Wildcard::match pattern
+  vector<string> wildcards;
+  Clear();
+  for (int i = 0; i < nbPat; i++) {
+    string a = addresses[rndl() % (nbAddress / 4)];
+    size_t len = 3 + rndl() % 6;
+    string p;
+    switch (i % 5) {
+    case 0:
+      p = a.substr(0, len) + "*";
+      Add(p);
+      break;
+    case 1:
+      p = a.substr(0, len);
+      p[1 + rndl() % (len - 1)] = '?';
+      p.push_back('*');
+      Add(p);
+      break;
+    case 2:
+      p = "*" + a.substr(a.length() - 3);
+      Add(p);
+      break;
+    case 3:
+      p = a.substr(0, 2) + "*" + a.substr(4 + rndl() % 20, 3) + "*";
+      Add(p);
+      break;
+    case 4:
+      // A literal only matches itself, not the addresses it starts
+      p = (i % 10 == 4) ? a : a.substr(0, len);
+      Add(p);
+      break;
+    }
+    wildcards.push_back(p);
+  }
+  Build();
+
+  int nbMatch = 0;
+  int nbError = 0;
+  for (int i = 0; i < nbAddress; i++) {
+    bool expected = false;
+    for (int j = 0; j < nbPat && !expected; j++)
+      expected = Wildcard::match(addresses[i].c_str(), wildcards[j].c_str());
+    int32_t id = Match(addresses[i].c_str());
+    if (id >= 0) nbMatch++;
+    if ((id >= 0) != expected || (id >= 0 && !Wildcard::match(addresses[i].c_str(), wildcards[id].c_str())))
+      nbError++;
+  }
+
+  bool ok = (nbError == 0);
+  if (ok) {
+    printf("OK (%d/%d addresses matched, %u states)\n", nbMatch, nbAddress, GetNbState());
+  } else {
+    printf("Failed ! (%d errors on %d addresses)\n", nbError, nbAddress);
+  }
+  Clear();
+  return ok;
+
+}
+
+static volatile int benchSink;
+
+// Rates (Kaddr/s) of the Wildcard::match loop and of the matcher for a
+// pattern set, false if the results differ
+static bool benchSet(vector<string> &addresses, vector<string> &wildcards, double *rate) {
+
+  int nbAddress = (int)addresses.size();
+  int nbPat = (int)wildcards.size();
+  PatternMatcher m;
+  for (int i = 0; i < nbPat; i++)
+    m.Add(wildcards[i]);
+  m.Build();
+
+  // Every pattern on every address, limited to ~2^24 Wildcard::match
+  int nbLoop = std::max(16, std::min(nbAddress, (1 << 24) / nbPat));
+  int nbLoopMatch = 0;
+  int nbMatch = 0;
+  double t0 = Timer::get_tick();
+  for (int i = 0; i < nbLoop; i++)
+    for (int j = 0; j < nbPat; j++)
+      if (Wildcard::match(addresses[i].c_str(), wildcards[j].c_str())) {
+        nbLoopMatch++;
+        break;
+      }
+  double t1 = Timer::get_tick();
+  for (int i = 0; i < nbAddress; i++)
+    if (m.Match(addresses[i].c_str()) >= 0 && i < nbLoop)
+      nbMatch++;
+
+  // Steady state, passes over the addresses for at least 0.1 s
+  double t2 = Timer::get_tick();
+  int nbPass = 0;
+  int nbPassMatch = 0;
+  do {
+    for (int i = 0; i < nbAddress; i++)
+      if (m.Match(addresses[i].c_str()) >= 0)
+        nbPassMatch++;
+    nbPass++;
+  } while (Timer::get_tick() - t2 < 0.1);
+  double t3 = Timer::get_tick();
+  benchSink = nbPassMatch;
+
+  rate[0] = (double)nbLoop / ((t1 - t0) * 1e3);
+  rate[1] = (double)nbAddress * nbPass / ((t3 - t2) * 1e3);
+  return nbMatch == nbLoopMatch;
+
+}
+
+void PatternMatcher::Bench(Secp256K1 *secp) {
+
+  const int nbAddress = 1 << 14;
+
+  vector<string> addresses(nbAddress);
+  for (int i = 0; i < nbAddress; i++)
+    addresses[i] = randomAddress(secp);
+
+  printf("PatternMatcher: address matching (Kaddr/s), %d addresses\n", nbAddress);
+  printf("%10s %12s %12s %12s %12s\n", "Patterns", "Prefix loop", "Prefix", "Mixed loop", "Mixed");
+
+  for (int nbPat = 1; nbPat <= 100000; nbPat *= 10) {
+
+    // Prefixes "1xxxxx*", the mixed set has one in 10 with a '?' and
+    // one in 10 with a '*' after 3 characters
+    vector<string> prefixes;
+    vector<string> mixed;
+    for (int i = 0; i < nbPat; i++) {
+      string p = "1";
+      for (int j = 0; j < 5; j++)
+        p.push_back(b58[rndl() % 58]);
+      p.push_back('*');
+      prefixes.push_back(p);
+      if (i % 10 == 1) p[2] = '?';
+      if (i % 10 == 2) p.insert(3, "*");
+      mixed.push_back(p);
+    }
+
+    double rate[4];
+    bool ok = benchSet(addresses, prefixes, rate);
+    ok = benchSet(addresses, mixed, rate + 2) && ok;
+    printf("%10d %12.1f %12.1f %12.1f %12.1f%s\n", nbPat, rate[0], rate[1], rate[2], rate[3],
+      ok ? "" : " (results differ !)");
+
+  }
+
+}
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATTERNMATCHERH
+#define PATTERNMATCHERH
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "SECP256k1.h"
+
+// Characters of a transition row: the 58 Base58 digits, then '0' and 'l'
+// (Bech32 only)
+#define PATTERN_NB_CHAR 60
+
+// No transition
+#define PATTERN_NONE 0xFFFFFFFF
+
+// Transition flag of a match, the rest of the address is not read
+#define PATTERN_ACCEPT 0x80000000
+
+// Transition flag of a sparse DFA state
+#define PATTERN_SPARSE 0x40000000
+
+// DFA states with up to PATTERN_NB_SPARSE transitions are stored as a
+// list instead of a row, most states of a large set (their trie leaves)
+// have one or two, the automaton then stays in the caches
+#define PATTERN_NB_SPARSE 4
+
+// Active nodes of the '*' automaton kept on the stack, more spill to the heap
+#define PATTERN_LOCAL_STATE 256
+
+// DFA states above which the patterns are left to the '*' automaton
+#define PATTERN_MAX_STATE (1 << 19)
+
+// A single pattern is matched by Wildcard::match, as fast as the DFA
+// (-bench)
+#define PATTERN_MIN_TRIE 2
+
+// Pattern set compiled into automata with dense transition rows indexed by
+// the address character. Patterns without '*', or with a single '*' at the
+// end, are compiled into a DFA (subset construction of their trie): one
+// transition per character whatever the number of patterns, and a
+// trailing '*' accepts as soon as its prefix is read.
+// The other patterns go to a trie where '?' and '*' are edges, walked as an
+// NFA: a '*' node stays live once reached, the other active nodes are
+// reached from a single parent and never need to be deduplicated.
+// Patterns follow Wildcard::match: the whole address must match, a pattern
+// without '?' or '*' only matches itself.
+class PatternMatcher {
+
+public:
+
+  PatternMatcher();
+
+  // Add a pattern, Build() must be called before Match() and after
+  // the last Add()
+  void Add(std::string pattern);
+  void Build();
+  void Clear();
+
+  uint32_t GetSize();
+
+  // DFA states and NFA nodes
+  uint32_t GetNbState();
+
+  // Index of a matching pattern or -1 (str is an address), thread safe
+  int32_t Match(const char *str);
+
+  // Compare with Wildcard::match on random addresses and patterns
+  bool Check(Secp256K1 *secp);
+
+  // Addresses/s of the Wildcard::match loop and of the matcher
+  static void Bench(Secp256K1 *secp);
+
+private:
+
+  // Trie of a pattern group, '?' and '*' are edges like the characters
+  typedef struct {
+    std::vector<std::vector<std::pair<char, uint32_t>>> children;
+    std::vector<int32_t> accept;
+  } PATTERN_TRIE;
+
+  static void TrieAdd(PATTERN_TRIE &t, const std::string &p, int32_t index);
+  static uint32_t TrieChild(PATTERN_TRIE &t, uint32_t node, char c);
+  bool BuildDFA(PATTERN_TRIE &t);
+  void BuildNFA(PATTERN_TRIE &t);
+  int32_t MatchDFA(const char *str);
+  int32_t MatchNFA(const char *str);
+
+  uint32_t nbPattern;
+  std::vector<std::string> patterns;
+
+  // DFA, row s of dfaNext holds the transitions of dense state s and
+  // dfaAccept[s] the pattern matching at the end of the address. A
+  // transition to PATTERN_SPARSE|i goes to dfaSparse[i].
+  typedef struct {
+    uint8_t nb;
+    uint8_t c[PATTERN_NB_SPARSE];
+    uint32_t next[PATTERN_NB_SPARSE];
+    int32_t accept;
+  } PATTERN_SPARSE_STATE;
+
+  std::vector<uint32_t> dfaNext;
+  std::vector<int32_t> dfaAccept;
+  std::vector<PATTERN_SPARSE_STATE> dfaSparse;
+  uint32_t dfaStart;
+  int32_t acceptAll;
+
+  // NFA, row n of nfaNext holds the character children of node n
+  typedef struct {
+    uint32_t anyChild;
+    uint32_t starChild;
+    int32_t accept;
+  } PATTERN_NODE;
+
+  std::vector<uint32_t> nfaNext;
+  std::vector<PATTERN_NODE> nfaNodes;
+
+};
+
+#endif // PATTERNMATCHERH
@@ -18,11 +18,18 @@
 #include "SECP256k1.h"
 #include "hash/sha256.h"
 #include "hash/ripemd160.h"
+#include "hash/hash160.h"
 #include "Base58.h"
 #include "Bech32.h"
+#include "Random.h"
+#include "Timer.h"
+#include "CPUFeatures.h"
 #include <string.h>
+#include <algorithm>
 
 Secp256K1::Secp256K1() {
+  hashLanes = 4;
+  useSSE4 = true;
 }
 
 void Secp256K1::Init() {
@@ -54,6 +61,11 @@ void Secp256K1::Init() {
     GTable[i * 256 + 255] = N; // Dummy point for check function
   }
 
+  // Widest hash160 kernel of the CPU, with SHA-NI the scalar hash160 is
+  // faster than SSE x4
+  hashLanes = CPUFeatures::GetHashLanes();
+  useSSE4 = CPUFeatures::UseSSE4();
+
 }
 
 Secp256K1::~Secp256K1() {
@@ -102,6 +114,60 @@ void CheckAddress(Secp256K1 *T,std::string address,std::string privKeyStr) {
 
 }
 
+// SHA-NI against the scalar SHA-256 on random inputs of every length
+static bool CheckSha256Ni() {
+
+  unsigned char in[256];
+  unsigned char h0[32];
+  unsigned char h1[32];
+  bool ok = true;
+
+  for (int len = 0; len < 200; len++) {
+    for (int i = 0; i < len; i++)
+      in[i] = (unsigned char)rndl();
+    sha256_use_shani(false);
+    sha256(in, len, h0);
+    if (len < 56) sha256_checksum(in, len, h0 + 28);
+    if (len == 33) sha256_33(in, h0);
+    if (len == 65) sha256_65(in, h0);
+    sha256_use_shani(true);
+    sha256(in, len, h1);
+    if (len < 56) sha256_checksum(in, len, h1 + 28);
+    if (len == 33) sha256_33(in, h1);
+    if (len == 65) sha256_65(in, h1);
+    ok = ok && (memcmp(h0, h1, 32) == 0);
+  }
+
+  return ok;
+
+}
+
+// Allocation free base58 encoder against EncodeBase58: leading zero bytes,
+// all zero and 0xFF payloads
+static bool CheckBase58Address() {
+
+  const int nbPayload = 1023;
+  unsigned char q[25];
+  char str[BASE58_ADDRESS_SIZE];
+
+  bool ok = true;
+  for (int i = 0; i < nbPayload && ok; i++) {
+    for (int j = 0; j < 25; j++)
+      q[j] = (unsigned char)rndl();
+    int nbZero = (i < 26) ? i : (int)(rndl() % 4);
+    memset(q, 0, nbZero);
+    if (i == 26) memset(q, 0xFF, 25);
+    if (i == 27) q[0] = 0xFF;
+    // EncodeBase58 adds a '1' to the all zero payload (no checksum gives it)
+    std::string ref = (i == 25) ? std::string(25, '1') : EncodeBase58(q, q + 25);
+    int len = EncodeBase58Address(q, str);
+    ok = (ref == str) && (len == (int)ref.length());
+  }
+
+  return ok;
+
+}
+
 void Secp256K1::Check() {
 
   printf("Check Generator :");
@@ -166,6 +232,18 @@ void Secp256K1::Check() {
   printf("Check Calc PubKey (odd) %s:",GetAddress(P2PKH, true, pub).c_str());
   PrintResult(EC(pub));
 
+  printf("Check SHA-256 SHA-NI :");
+  if (sha256shani_supported())
+    PrintResult(CheckSha256Ni());
+  else
+    printf("not supported\n");
+
+  printf("Check Hash160 SIMD :");
+  PrintResult(CheckHash160Lanes());
+
+  printf("Check Base58 address :");
+  PrintResult(CheckBase58Address());
+
 }
 
 
@@ -273,23 +351,17 @@ Int Secp256K1::DecodePrivateKey(char *key,bool *compressed) {
 
 }
 
-#define KEYBUFFCOMP(buff,p) \
-(buff)[0] = ((p).x.bits[7] >> 8) | ((uint32_t)(0x2 + (p).y.IsOdd()) << 24); \
-(buff)[1] = ((p).x.bits[6] >> 8) | ((p).x.bits[7] <<24); \
-(buff)[2] = ((p).x.bits[5] >> 8) | ((p).x.bits[6] <<24); \
-(buff)[3] = ((p).x.bits[4] >> 8) | ((p).x.bits[5] <<24); \
-(buff)[4] = ((p).x.bits[3] >> 8) | ((p).x.bits[4] <<24); \
-(buff)[5] = ((p).x.bits[2] >> 8) | ((p).x.bits[3] <<24); \
-(buff)[6] = ((p).x.bits[1] >> 8) | ((p).x.bits[2] <<24); \
-(buff)[7] = ((p).x.bits[0] >> 8) | ((p).x.bits[1] <<24); \
-(buff)[8] = 0x00800000 | ((p).x.bits[0] <<24); \
-(buff)[9] = 0; \
-(buff)[10] = 0; \
-(buff)[11] = 0; \
-(buff)[12] = 0; \
-(buff)[13] = 0; \
-(buff)[14] = 0; \
-(buff)[15] = 0x108;
+// SoA x words and parity of the compressed key p, lane l of n (hash160*_comp)
+#define KEYSOACOMP(x,odd,n,l,p) \
+(x)[0 * (n) + (l)] = (p).x.bits[7]; \
+(x)[1 * (n) + (l)] = (p).x.bits[6]; \
+(x)[2 * (n) + (l)] = (p).x.bits[5]; \
+(x)[3 * (n) + (l)] = (p).x.bits[4]; \
+(x)[4 * (n) + (l)] = (p).x.bits[3]; \
+(x)[5 * (n) + (l)] = (p).x.bits[2]; \
+(x)[6 * (n) + (l)] = (p).x.bits[1]; \
+(x)[7 * (n) + (l)] = (p).x.bits[0]; \
+(odd)[l] = (uint32_t)(p).y.IsOdd();
 
 #define KEYBUFFUNCOMP(buff,p) \
 (buff)[0] = ((p).x.bits[7] >> 8) | 0x04000000; \
@@ -382,18 +454,16 @@ void Secp256K1::GetHash160(int type,bool compressed,
 
     } else {
 
-      uint32_t b0[16];
-      uint32_t b1[16];
-      uint32_t b2[16];
-      uint32_t b3[16];
+      uint32_t x[8 * 4];
+      uint32_t odd[4];
+      uint8_t *h[4] = { h0, h1, h2, h3 };
 
-      KEYBUFFCOMP(b0, k0);
-      KEYBUFFCOMP(b1, k1);
-      KEYBUFFCOMP(b2, k2);
-      KEYBUFFCOMP(b3, k3);
+      KEYSOACOMP(x, odd, 4, 0, k0);
+      KEYSOACOMP(x, odd, 4, 1, k1);
+      KEYSOACOMP(x, odd, 4, 2, k2);
+      KEYSOACOMP(x, odd, 4, 3, k3);
 
-      sha256sse_1B(b0, b1, b2, b3, sh0, sh1, sh2, sh3);
-      ripemd160sse_32(sh0, sh1, sh2, sh3, h0, h1, h2, h3);
+      hash160sse_comp(x, odd, h);
 
     }
 
@@ -431,6 +501,95 @@ void Secp256K1::GetHash160(int type,bool compressed,
 
 }
 
+// Hash160 of N points with the N lanes kernels, the compressed keys with
+// the fused hash160 kernel
+template <int N,
+  void (*SHA1B)(uint32_t **, uint8_t **),
+  void (*SHA2B)(uint32_t **, uint8_t **),
+  void (*RIPE32)(uint8_t **, uint8_t **),
+  void (*H160C)(const uint32_t *, const uint32_t *, uint8_t **)>
+static void GetHash160Lanes(int type, bool compressed, Point *k, uint8_t **h) {
+
+#ifdef WIN64
+  __declspec(align(64)) unsigned char sh[N][32];
+#else
+  unsigned char sh[N][32] __attribute__((aligned(64)));
+#endif
+  uint32_t b[N][32];
+  uint32_t *bp[N];
+  uint8_t *shp[N];
+
+  for (int j = 0; j < N; j++) {
+    bp[j] = b[j];
+    shp[j] = sh[j];
+  }
+
+  switch (type) {
+
+  case P2PKH:
+  case BECH32:
+  {
+
+    if (!compressed) {
+      for (int j = 0; j < N; j++) {
+        KEYBUFFUNCOMP(b[j], k[j]);
+      }
+      SHA2B(bp, shp);
+      RIPE32(shp, h);
+    } else {
+      uint32_t x[8 * N];
+      uint32_t odd[N];
+      for (int j = 0; j < N; j++) {
+        KEYSOACOMP(x, odd, N, j, k[j]);
+      }
+      H160C(x, odd, h);
+    }
+
+  }
+  break;
+
+  case P2SH:
+  {
+
+    unsigned char kh[N][20];
+    uint8_t *khp[N];
+    for (int j = 0; j < N; j++)
+      khp[j] = kh[j];
+
+    GetHash160Lanes<N, SHA1B, SHA2B, RIPE32, H160C>(P2PKH, compressed, k, khp);
+
+    // Redeem Script (1 to 1 P2SH)
+    for (int j = 0; j < N; j++) {
+      KEYBUFFSCRIPT(b[j], kh[j]);
+    }
+    SHA1B(bp, shp);
+    RIPE32(shp, h);
+
+  }
+  break;
+
+  }
+
+}
+
+void Secp256K1::GetHash160(int type, bool compressed, Point *k, uint8_t **h, int nbPoint) {
+
+  // Widest kernels first
+  int i = 0;
+  if (hashLanes >= 16)
+    for (; i + 16 <= nbPoint; i += 16)
+      GetHash160Lanes<16, sha256avx512_1B, sha256avx512_2B, ripemd160avx512_32, hash160avx512_comp>(type, compressed, k + i, h + i);
+  if (hashLanes >= 8)
+    for (; i + 8 <= nbPoint; i += 8)
+      GetHash160Lanes<8, sha256avx2_1B, sha256avx2_2B, ripemd160avx2_32, hash160avx2_comp>(type, compressed, k + i, h + i);
+  if (useSSE4)
+    for (; i + 4 <= nbPoint; i += 4)
+      GetHash160(type, compressed, k[i], k[i + 1], k[i + 2], k[i + 3], h[i], h[i + 1], h[i + 2], h[i + 3]);
+  for (; i < nbPoint; i++)
+    GetHash160(type, compressed, k[i], h[i]);
+
+}
+
 uint8_t Secp256K1::GetByte(std::string &str, int idx) {
 
   char tmp[3];
@@ -642,68 +801,252 @@ std::string Secp256K1::GetPrivAddress(bool compressed,Int &privKey) {
 (buff)[14] = 0; \
 (buff)[15] = 0xA8;
 
-std::vector<std::string> Secp256K1::GetAddress(int type, bool compressed, unsigned char *h1, unsigned char *h2, unsigned char *h3, unsigned char *h4) {
+void Secp256K1::GetAddress(int type, bool compressed, unsigned char **h, char **addr, int n) {
 
-  std::vector<std::string> ret;
+  unsigned char add[16][25];
+  uint32_t b[16][16];
+  uint32_t *bp[16];
+  uint8_t *cp[16];
 
-  unsigned char add1[25];
-  unsigned char add2[25];
-  unsigned char add3[25];
-  unsigned char add4[25];
-  uint32_t b1[16];
-  uint32_t b2[16];
-  uint32_t b3[16];
-  uint32_t b4[16];
+  if (type == BECH32) {
+    for (int i = 0; i < n; i++)
+      segwit_addr_encode(addr[i], "bc", 0, h[i], 20);
+    return;
+  }
 
-  switch (type) {
+  for (int j = 0; j < 16; j++) {
+    add[j][0] = (type == P2SH) ? 0x05 : 0x00;
+    bp[j] = b[j];
+    cp[j] = add[j] + 21;
+  }
 
-  case P2PKH:
-    add1[0] = 0x00;
-    add2[0] = 0x00;
-    add3[0] = 0x00;
-    add4[0] = 0x00;
-    break;
+  for (int i = 0; i < n; i += 16) {
 
-  case P2SH:
-    add1[0] = 0x05;
-    add2[0] = 0x05;
-    add3[0] = 0x05;
-    add4[0] = 0x05;
-    break;
+    int m = std::min(16, n - i);
+    for (int j = 0; j < m; j++) {
+      memcpy(add[j] + 1, h[i + j], 20);
+      CHECKSUM(b[j], add[j]);
+    }
+
+    // Checksums, widest kernel first
+    int j = 0;
+    if (hashLanes >= 16 && m == 16) {
+      sha256avx512_checksum(bp, cp);
+      j = 16;
+    }
+    if (hashLanes >= 8)
+      for (; j + 8 <= m; j += 8)
+        sha256avx2_checksum(bp + j, cp + j);
+    if (useSSE4)
+      for (; j + 4 <= m; j += 4)
+        sha256sse_checksum(b[j], b[j + 1], b[j + 2], b[j + 3], cp[j], cp[j + 1], cp[j + 2], cp[j + 3]);
+    for (; j < m; j++)
+      sha256_checksum(add[j], 21, cp[j]);
+
+    // Base58
+    for (j = 0; j < m; j++)
+      EncodeBase58Address(add[j], addr[i + j]);
 
-  case BECH32:
-  {
-    char output[128];
-    segwit_addr_encode(output, "bc", 0, h1, 20);
-    ret.push_back(std::string(output));
-    segwit_addr_encode(output, "bc", 0, h2, 20);
-    ret.push_back(std::string(output));
-    segwit_addr_encode(output, "bc", 0, h3, 20);
-    ret.push_back(std::string(output));
-    segwit_addr_encode(output, "bc", 0, h4, 20);
-    ret.push_back(std::string(output));
-    return ret;
   }
-  break;
+
+}
+
+// ---------------------------------------------------------------------------------------
+
+bool Secp256K1::CheckHash160Lanes() {
+
+  Point p[16];
+  uint8_t h[16][20];
+  uint8_t *hp[16];
+  bool ok = true;
+
+  for (int j = 0; j < 16; j++) {
+    Int k;
+    k.Rand(256);
+    p[j] = ComputePublicKey(&k);
+    hp[j] = h[j];
   }
 
-  memcpy(add1 + 1, h1, 20);
-  memcpy(add2 + 1, h2, 20);
-  memcpy(add3 + 1, h3, 20);
-  memcpy(add4 + 1, h4, 20);
-  CHECKSUM(b1, add1);
-  CHECKSUM(b2, add2);
-  CHECKSUM(b3, add3);
-  CHECKSUM(b4, add4);
-  sha256sse_checksum(b1,b2,b3,b4,add1 + 21, add2 + 21, add3 + 21, add4 + 21);
+  // 16 (AVX-512), 8 (AVX2), 4 (SSE, also tested with SHA-NI) lanes
+  // hash160 and 12 (8+4) points against the scalar sha256/ripemd160
+  bool sse4 = useSSE4;
+  useSSE4 = true;
+  const int nbPoints[] = { 16, 8, 4, 12 };
+  for (int n = 0; n < 4; n++) {
+    for (int type = P2PKH; type <= BECH32; type++) {
+      for (int c = 0; c < 2; c++) {
+        memset(h, 0, sizeof(h));
+        GetHash160(type, c == 0, p, hp, nbPoints[n]);
+        for (int j = 0; j < nbPoints[n]; j++) {
+          uint8_t ch[20];
+          GetHash160(type, c == 0, p[j], ch);
+          ok = ok && (memcmp(h[j], ch, 20) == 0);
+        }
+      }
+    }
+  }
 
-  // Base58
-  ret.push_back(EncodeBase58(add1, add1 + 25));
-  ret.push_back(EncodeBase58(add2, add2 + 25));
-  ret.push_back(EncodeBase58(add3, add3 + 25));
-  ret.push_back(EncodeBase58(add4, add4 + 25));
+  // Address checksums
+  unsigned char add[16][25];
+  uint32_t b[16][16];
+  uint32_t *bp[16];
+  uint8_t *cp[16];
+  for (int j = 0; j < 16; j++) {
+    for (int i = 0; i < 21; i++)
+      add[j][i] = (unsigned char)rndl();
+    CHECKSUM(b[j], add[j]);
+    bp[j] = b[j];
+    cp[j] = add[j] + 21;
+  }
+  if (hashLanes >= 16) {
+    sha256avx512_checksum(bp, cp);
+    for (int j = 0; j < 16; j++) {
+      uint8_t cs[4];
+      sha256_checksum(add[j], 21, cs);
+      ok = ok && (memcmp(add[j] + 21, cs, 4) == 0);
+      memset(add[j] + 21, 0, 4);
+    }
+  }
+  if (hashLanes >= 8) {
+    sha256avx2_checksum(bp, cp);
+    for (int j = 0; j < 8; j++) {
+      uint8_t cs[4];
+      sha256_checksum(add[j], 21, cs);
+      ok = ok && (memcmp(add[j] + 21, cs, 4) == 0);
+    }
+  }
 
-  return ret;
+  // Batched addresses (every lane count, with and without SSE x4) against
+  // the single ones
+  char a[16][ADDRESS_SIZE];
+  char *ap[16];
+  for (int j = 0; j < 16; j++)
+    ap[j] = a[j];
+  for (int s = 0; s < 2; s++) {
+    useSSE4 = (s == 0) ? true : sse4;
+    for (int type = P2PKH; type <= BECH32; type++) {
+      for (int n = 1; n <= 16; n++) {
+        GetAddress(type, true, hp, ap, n);
+        for (int j = 0; j < n; j++)
+          ok = ok && (GetAddress(type, true, h[j]) == std::string(a[j]));
+      }
+    }
+  }
+  useSSE4 = sse4;
+
+  return ok;
+
+}
+
+void Secp256K1::BenchHash160() {
+
+  const int nbHash = 1 << 18;
+  const char *names[] = { "P2PKH comp", "P2PKH uncomp", "P2SH comp" };
+  const int types[] = { P2PKH, P2PKH, P2SH };
+  const bool comps[] = { true, false, true };
+
+  Point p[16];
+  uint8_t h[16][20];
+  uint8_t *hp[16];
+  for (int j = 0; j < 16; j++) {
+    Int k;
+    k.Rand(256);
+    p[j] = ComputePublicKey(&k);
+    hp[j] = h[j];
+  }
+
+  // Lanes per call, SSE x4 is forced in its column, without the kernel the
+  // wider calls fall back to the kernels used by the search
+  printf("Secp256K1: hash160 (Mhash/s), %d hashes\n", nbHash);
+  printf("%14s %12s %12s %12s %12s\n", "Type", "Scalar", "SSE x4",
+    hashLanes >= 8 ? "AVX2 x8" : "x8 (no AVX2)",
+    hashLanes >= 16 ? "AVX-512 x16" : "x16 (no 512)");
+
+  for (int t = 0; t < 3; t++) {
+
+    double rate[4];
+    double t0 = Timer::get_tick();
+    for (int n = 0; n < nbHash; n++)
+      GetHash160(types[t], comps[t], p[n & 15], h[n & 15]);
+    rate[0] = (double)nbHash / ((Timer::get_tick() - t0) * 1e6);
+    bool sse4 = useSSE4;
+    for (int l = 1; l < 4; l++) {
+      int nbLane = 2 << l;
+      useSSE4 = (l == 1);
+      t0 = Timer::get_tick();
+      for (int n = 0; n < nbHash; n += nbLane)
+        GetHash160(types[t], comps[t], p, hp, nbLane);
+      rate[l] = (double)nbHash / ((Timer::get_tick() - t0) * 1e6);
+    }
+    useSSE4 = sse4;
+    printf("%14s %12.2f %12.2f %12.2f %12.2f\n", names[t], rate[0], rate[1], rate[2], rate[3]);
+
+  }
+
+  // Base58Check of the per candidate path, string encoder against the
+  // allocation free one
+  unsigned char payload[16][25];
+  char str[16][BASE58_ADDRESS_SIZE];
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 25; j++)
+      payload[i][j] = (unsigned char)rndl();
+    payload[i][0] = 0;
+  }
+
+  const int nbAddress = nbHash / 4;
+  double ns[2];
+  for (int m = 0; m < 2; m++) {
+    double t0 = Timer::get_tick();
+    for (int n = 0; n < nbAddress; n += 16) {
+      payload[n & 15][1] = (unsigned char)n;
+      if (m == 0) {
+        for (int i = 0; i < 16; i++)
+          EncodeBase58(payload[i], payload[i] + 25);
+      } else {
+        for (int i = 0; i < 16; i++)
+          EncodeBase58Address(payload[i], str[i]);
+      }
+    }
+    ns[m] = (Timer::get_tick() - t0) * 1e9 / (double)nbAddress;
+  }
+
+  printf("Base58Check address (ns/address), %d addresses\n", nbAddress);
+  printf("%14s %16s\n", "EncodeBase58", "Allocation free");
+  printf("%14.1f %16.1f\n", ns[0], ns[1]);
+
+  // Single buffer SHA-256 of the per candidate path (address checksum,
+  // public key hash, WIF), scalar and SHA-NI
+  if (!sha256shani_supported())
+    return;
+
+  const char *sNames[] = { "checksum", "33 bytes", "65 bytes", "address" };
+  unsigned char in[128];
+  unsigned char d[32];
+  for (int i = 0; i < 128; i++)
+    in[i] = (unsigned char)rndl();
+
+  printf("SHA-256 single buffer (Mhash/s), %d hashes\n", nbHash);
+  printf("%14s %12s %12s\n", "Input", "Scalar", "SHA-NI");
+  for (int t = 0; t < 4; t++) {
+    double rate[2];
+    for (int m = 0; m < 2; m++) {
+      sha256_use_shani(m == 1);
+      int nb = (t == 3) ? nbHash / 16 : nbHash;
+      double t0 = Timer::get_tick();
+      for (int n = 0; n < nb; n++) {
+        in[0] = (unsigned char)n;
+        switch (t) {
+        case 0: sha256_checksum(in, 21, d); break;
+        case 1: sha256_33(in, d); break;
+        case 2: sha256_65(in, d); break;
+        default: GetAddress(P2PKH, true, in); break;
+        }
+      }
+      rate[m] = (double)nb / ((Timer::get_tick() - t0) * 1e6);
+    }
+    printf("%14s %12.2f %12.2f\n", sNames[t], rate[0], rate[1]);
+  }
+  sha256_use_shani(true);
 
 }
 
@@ -732,7 +1075,9 @@ std::string Secp256K1::GetAddress(int type, bool compressed,unsigned char *hash1
   sha256_checksum(address,21,address+21);
 
   // Base58
-  return EncodeBase58(address, address + 25);
+  char str[BASE58_ADDRESS_SIZE];
+  EncodeBase58Address(address, str);
+  return std::string(str);
 
 }
 
@@ -771,7 +1116,9 @@ std::string Secp256K1::GetAddress(int type, bool compressed, Point &pubKey) {
   sha256_checksum(address, 21, address + 21);
 
   // Base58
-  return EncodeBase58(address, address + 25);
+  char str[BASE58_ADDRESS_SIZE];
+  EncodeBase58Address(address, str);
+  return std::string(str);
 
 }
 
@@ -27,6 +27,9 @@
 #define P2SH   1
 #define BECH32 2
 
+// Address buffer of the batched GetAddress() (bech32 is the longest)
+#define ADDRESS_SIZE 64
+
 class Secp256K1 {
 
 public:
@@ -37,17 +40,24 @@ public:
   Point ComputePublicKey(Int *privKey);
   Point NextKey(Point &key);
   void Check();
+  void BenchHash160();
   bool  EC(Point &p);
 
   void GetHash160(int type,bool compressed,
     Point &k0, Point &k1, Point &k2, Point &k3,
     uint8_t *h0, uint8_t *h1, uint8_t *h2, uint8_t *h3);
 
+  // nbPoint points k[] to h[], with the AVX-512 (16 lanes) and AVX2 (8 lanes)
+  // kernels when the CPU has them, then SSE (4 lanes)
+  void GetHash160(int type, bool compressed, Point *k, uint8_t **h, int nbPoint);
+
   void GetHash160(int type,bool compressed, Point &pubKey, unsigned char *hash);
 
   std::string GetAddress(int type, bool compressed, Point &pubKey);
   std::string GetAddress(int type, bool compressed, unsigned char *hash160);
-  std::vector<std::string> GetAddress(int type, bool compressed, unsigned char *h1, unsigned char *h2, unsigned char *h3, unsigned char *h4);
+  // n hash160 h[] to zero terminated addresses addr[] (ADDRESS_SIZE bytes),
+  // checksums 4 at a time and no allocation
+  void GetAddress(int type, bool compressed, unsigned char **h, char **addr, int n);
   std::string GetPrivAddress(bool compressed, Int &privKey );
   std::string GetPublicKeyHex(bool compressed, Point &p);
   Point ParsePublicKeyHex(std::string str, bool &isCompressed);
@@ -68,9 +78,12 @@ public:
 private:
 
   uint8_t GetByte(std::string &str,int idx);
+  bool CheckHash160Lanes();
 
   Int GetY(Int x, bool isEven);
   Point GTable[256*32];       // Generator table
+  int hashLanes;              // Widest hash160 kernel (CPUFeatures)
+  bool useSSE4;               // SSE x4 kernels for the groups of 4
 
 };
 
@@ -0,0 +1,353 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TargetDB.h"
+#include "Base58.h"
+#include "Bech32.h"
+#include "SECP256k1.h"
+#include "Timer.h"
+#include "hash/sha256.h"
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#include <algorithm>
+#ifdef WIN64
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define TARGETDB_MAGIC "VSHASH01"
+
+// Records hashed per block for the digest
+#define TARGETDB_DIGEST_BLOCK (1 << 16)
+
+using namespace std;
+
+typedef struct {
+  uint8_t h[20];
+} HASH160;
+
+static bool operator<(const HASH160 &a, const HASH160 &b) {
+  return memcmp(a.h, b.h, 20) < 0;
+}
+
+static bool operator==(const HASH160 &a, const HASH160 &b) {
+  return memcmp(a.h, b.h, 20) == 0;
+}
+
+// ----------------------------------------------------------------------------
+
+TargetDB::TargetDB() {
+
+  header = NULL;
+  index = NULL;
+  records = NULL;
+  mapSize = 0;
+#ifdef WIN64
+  hFile = INVALID_HANDLE_VALUE;
+  hMap = NULL;
+#else
+  fd = -1;
+#endif
+
+}
+
+TargetDB::~TargetDB() {
+  Close();
+}
+
+// ----------------------------------------------------------------------------
+
+// Invalid lines printed by Convert()
+#define TARGETDB_MAX_INVALID_PRINT 10
+
+// Hash160 of a full address, type is P2PKH, P2SH, BECH32, -1 (not an
+// address) or -2 (bad checksum or version byte)
+static int DecodeAddress(string &address, uint8_t *h) {
+
+  if (address.length() < 2)
+    return -1;
+
+  if (address[0] == 'b' || address[0] == 'B') {
+    std::transform(address.begin(), address.end(), address.begin(), ::tolower);
+    if (strncmp(address.c_str(), "bc1q", 4) != 0)
+      return -1;
+    uint8_t witprog[40];
+    size_t witprog_len;
+    int witver;
+    if (!segwit_addr_decode(&witver, witprog, &witprog_len, "bc", address.c_str()) || witprog_len != 20)
+      return -2;
+    memcpy(h, witprog, 20);
+    return BECH32;
+  }
+
+  if (address[0] != '1' && address[0] != '3')
+    return -1;
+  vector<unsigned char> result;
+  if (!DecodeBase58(address, result) || result.size() != 25)
+    return -1;
+  uint8_t chk[4];
+  sha256_checksum(result.data(), 21, chk);
+  if (memcmp(chk, result.data() + 21, 4) != 0 || result[0] != ((address[0] == '1') ? 0x00 : 0x05))
+    return -2;
+  memcpy(h, result.data() + 1, 20);
+  return (address[0] == '1') ? P2PKH : P2SH;
+
+}
+
+bool TargetDB::Convert(string inputFile, string outputFile) {
+
+  FILE *in = fopen(inputFile.c_str(), "r");
+  if (in == NULL) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot open %s %s\n", inputFile.c_str(), strerror(errno));
+    return false;
+  }
+
+  double t0 = Timer::get_tick();
+  vector<HASH160> hashes;
+  int type = -1;
+  uint64_t nbLine = 0;
+  uint64_t nbIgnored = 0;
+  uint64_t nbInvalid = 0;
+  char line[256];
+  HASH160 h;
+
+  while (fgets(line, sizeof(line), in)) {
+    string address(line);
+    while (address.length() > 0 && isspace((unsigned char)address.back()))
+      address.pop_back();
+    if (address.length() == 0)
+      continue;
+    nbLine++;
+    int aType = DecodeAddress(address, h.h);
+    if (aType == -2) {
+      if (nbInvalid < TARGETDB_MAX_INVALID_PRINT)
+        printf("TargetDB: line %llu, invalid address %s (checksum or version)\n", (unsigned long long)nbLine, address.c_str());
+      nbInvalid++;
+      continue;
+    }
+    if (aType < 0) {
+      nbIgnored++;
+      continue;
+    }
+    if (type == -1) type = aType;
+    if (aType != type) {
+      fprintf(stderr, "[ERROR] TargetDB: %s, P2PKH, P2SH or BECH32 allowed at once\n", address.c_str());
+      fclose(in);
+      return false;
+    }
+    hashes.push_back(h);
+  }
+  fclose(in);
+
+  if (hashes.size() == 0) {
+    fprintf(stderr, "[ERROR] TargetDB: no full address in %s\n", inputFile.c_str());
+    return false;
+  }
+
+  std::sort(hashes.begin(), hashes.end());
+  hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+  TARGETDB_HEADER hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, TARGETDB_MAGIC, 8);
+  hdr.type = (uint32_t)type;
+  hdr.count = hashes.size();
+
+  // 16 bits buckets
+  vector<uint64_t> idx(TARGETDB_NBBUCKET + 1);
+  uint64_t pos = 0;
+  for (uint32_t b = 0; b < TARGETDB_NBBUCKET; b++) {
+    idx[b] = pos;
+    while (pos < hashes.size() && (((uint32_t)hashes[pos].h[0] << 8) | hashes[pos].h[1]) == b)
+      pos++;
+  }
+  idx[TARGETDB_NBBUCKET] = pos;
+
+  // sha256 of the block digests
+  vector<uint8_t> blockDigests;
+  for (uint64_t i = 0; i < hashes.size(); i += TARGETDB_DIGEST_BLOCK) {
+    uint64_t n = std::min((uint64_t)TARGETDB_DIGEST_BLOCK, (uint64_t)hashes.size() - i);
+    uint8_t d[32];
+    sha256((uint8_t *)hashes[i].h, (int)(n * 20), d);
+    blockDigests.insert(blockDigests.end(), d, d + 32);
+  }
+  sha256(blockDigests.data(), (int)blockDigests.size(), hdr.digest);
+
+  string tmpName = outputFile + ".tmp";
+  FILE *f = fopen(tmpName.c_str(), "wb");
+  if (f == NULL) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot open %s %s\n", tmpName.c_str(), strerror(errno));
+    return false;
+  }
+
+  bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+  ok = ok && fwrite(idx.data(), sizeof(uint64_t), idx.size(), f) == idx.size();
+  ok = ok && fwrite(hashes.data(), sizeof(HASH160), hashes.size(), f) == hashes.size();
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot write %s %s\n", tmpName.c_str(), strerror(errno));
+    remove(tmpName.c_str());
+    return false;
+  }
+
+#ifdef WIN64
+  ok = MoveFileExA(tmpName.c_str(), outputFile.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+  ok = (rename(tmpName.c_str(), outputFile.c_str()) == 0);
+#endif
+
+  if (!ok) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot rename %s to %s\n", tmpName.c_str(), outputFile.c_str());
+    return false;
+  }
+
+  double t1 = Timer::get_tick();
+  printf("TargetDB: %llu addresses, %llu ignored, %llu invalid, %llu unique hash160 written to %s in %.1f s\n",
+    (unsigned long long)nbLine, (unsigned long long)nbIgnored, (unsigned long long)nbInvalid, (unsigned long long)hashes.size(),
+    outputFile.c_str(), t1 - t0);
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool TargetDB::Open(string fileName) {
+
+  Close();
+  this->fileName = fileName;
+  uint64_t size;
+
+#ifdef WIN64
+
+  hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot open %s\n", fileName.c_str());
+    return false;
+  }
+  LARGE_INTEGER fSize;
+  if (!GetFileSizeEx(hFile, &fSize)) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot read %s\n", fileName.c_str());
+    Close();
+    return false;
+  }
+  size = (uint64_t)fSize.QuadPart;
+  void *ptr = NULL;
+  if (size >= sizeof(TARGETDB_HEADER)) {
+    hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    ptr = (hMap != NULL) ? MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+  }
+  if (ptr == NULL) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot map %s\n", fileName.c_str());
+    Close();
+    return false;
+  }
+
+#else
+
+  fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot open %s %s\n", fileName.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(TARGETDB_HEADER)) {
+    fprintf(stderr, "[ERROR] TargetDB: %s is truncated\n", fileName.c_str());
+    Close();
+    return false;
+  }
+  size = (uint64_t)st.st_size;
+  void *ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    fprintf(stderr, "[ERROR] TargetDB: cannot map %s %s\n", fileName.c_str(), strerror(errno));
+    Close();
+    return false;
+  }
+
+#endif
+
+  mapSize = size;
+  header = (TARGETDB_HEADER *)ptr;
+  index = (const uint64_t *)((uint8_t *)ptr + sizeof(TARGETDB_HEADER));
+  records = (const uint8_t *)(index + TARGETDB_NBBUCKET + 1);
+
+  uint64_t expected = sizeof(TARGETDB_HEADER) + (TARGETDB_NBBUCKET + 1) * sizeof(uint64_t);
+  if (strncmp(header->magic, TARGETDB_MAGIC, 8) != 0 || header->type > BECH32 || size < expected) {
+    fprintf(stderr, "[ERROR] TargetDB: %s is not a target database\n", fileName.c_str());
+    Close();
+    return false;
+  }
+  if (size != expected + header->count * 20 || index[TARGETDB_NBBUCKET] != header->count) {
+    fprintf(stderr, "[ERROR] TargetDB: %s is truncated\n", fileName.c_str());
+    Close();
+    return false;
+  }
+
+  return true;
+
+}
+
+void TargetDB::Close() {
+
+#ifdef WIN64
+  if (header) UnmapViewOfFile(header);
+  if (hMap) CloseHandle(hMap);
+  if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+  hMap = NULL;
+  hFile = INVALID_HANDLE_VALUE;
+#else
+  if (header) munmap(header, mapSize);
+  if (fd >= 0) close(fd);
+  fd = -1;
+#endif
+  header = NULL;
+  index = NULL;
+  records = NULL;
+
+}
+
+// ----------------------------------------------------------------------------
+
+int TargetDB::GetType() {
+  return (int)header->type;
+}
+
+uint64_t TargetDB::GetSize() {
+  return header->count;
+}
+
+string TargetDB::GetDigest() {
+  return sha256_hex(header->digest);
+}
+
+const uint8_t *TargetDB::GetRecord(uint64_t i) {
+  return records + i * 20;
+}
+
+void TargetDB::GetBucket(uint16_t sAddress, uint64_t &begin, uint64_t &end) {
+
+  // address_t is read little endian from the hash160
+  uint32_t b = ((uint32_t)(sAddress & 0xFF) << 8) | (uint32_t)(sAddress >> 8);
+  begin = index[b];
+  end = index[b + 1];
+
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TARGETDBH
+#define TARGETDBH
+
+#include <string>
+#include <string.h>
+#include <vector>
+#include <stdint.h>
+#include <xmmintrin.h>
+#ifdef WIN64
+#include <Windows.h>
+#endif
+
+// Number of 16 bits buckets in the index (first 2 bytes of the hash160)
+#define TARGETDB_NBBUCKET 65536
+
+// Header of a target database file, followed by the bucket index
+// (TARGETDB_NBBUCKET+1 uint64 record offsets) and by the records
+// (20 bytes hash160, sorted and unique)
+typedef struct {
+
+  char     magic[8];
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t count;
+  uint8_t  digest[32];
+  uint8_t  pad[8];
+
+} TARGETDB_HEADER;
+
+// Full address targets stored as a memory mapped sorted hash160 table,
+// the file is shared through the page cache by every process using it
+class TargetDB {
+
+public:
+
+  TargetDB();
+  ~TargetDB();
+
+  // Read the addresses of inputFile (one per line) and write the database.
+  // Prefixes and wildcards are ignored, all addresses must have the same type.
+  static bool Convert(std::string inputFile, std::string outputFile);
+
+  bool Open(std::string fileName);
+  void Close();
+
+  int GetType();
+  uint64_t GetSize();
+  std::string GetDigest();
+  const uint8_t *GetRecord(uint64_t i);
+
+  // Record range of the 16 bits prefix (address_t, little endian)
+  void GetBucket(uint16_t sAddress, uint64_t &begin, uint64_t &end);
+
+  // Bucket bounds of the hash160
+  inline void Prefetch(const uint8_t *h) {
+    _mm_prefetch((const char *)&index[((uint32_t)h[0] << 8) | (uint32_t)h[1]], _MM_HINT_T0);
+  }
+
+  // Index of the hash160 or -1
+  inline int64_t Find(const uint8_t *h) {
+    uint32_t b = ((uint32_t)h[0] << 8) | (uint32_t)h[1];
+    uint64_t lo = index[b];
+    uint64_t hi = index[b + 1];
+    while (lo < hi) {
+      uint64_t mid = (lo + hi) >> 1;
+      int c = memcmp(records + mid * 20 + 2, h + 2, 18);
+      if (c == 0) return (int64_t)mid;
+      if (c < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    return -1;
+  }
+
+private:
+
+  std::string fileName;
+  TARGETDB_HEADER *header;
+  const uint64_t *index;
+  const uint8_t *records;
+  uint64_t mapSize;
+
+#ifdef WIN64
+  HANDLE hFile;
+  HANDLE hMap;
+#else
+  int fd;
+#endif
+
+};
+
+#endif // TARGETDBH
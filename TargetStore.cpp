@@ -0,0 +1,242 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TargetStore.h"
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+#define _64K 65536
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+TargetStore::TargetStore() {
+  Clear();
+}
+
+void TargetStore::Clear() {
+
+  vector<uint8_t>().swap(addHash160);
+  vector<address_t>().swap(addRefBucket);
+  vector<uint32_t>().swap(addRefId);
+
+  bucket.assign(_64K + 1, 0);
+  vector<uint8_t>().swap(hash160);
+  vector<atomic<uint64_t>>().swap(found);
+  nbFound = 0;
+
+  vector<PREFIX_TARGET>().swap(prefixes);
+  nbGroup = 0;
+  vector<atomic<uint8_t>>().swap(prefixFound);
+  prefixBucket.assign(_64K + 1, 0);
+  vector<uint32_t>().swap(prefixRef);
+
+}
+
+uint32_t TargetStore::GetNbFull() {
+  return (uint32_t)(hash160.size() / 20);
+}
+
+uint32_t TargetStore::GetNbPrefix() {
+  return (uint32_t)prefixes.size();
+}
+
+uint32_t TargetStore::GetNbTarget() {
+  return GetNbFull() + nbGroup;
+}
+
+uint32_t TargetStore::GetNbFound() {
+  return nbFound;
+}
+
+void TargetStore::AddFull(const uint8_t *hash160, size_t count) {
+  addHash160.insert(addHash160.end(), hash160, hash160 + count * 20);
+}
+
+void TargetStore::AddPrefix(PREFIX_TARGET &target, address_t sAddress) {
+
+  uint32_t id = (uint32_t)prefixes.size();
+  prefixes.push_back(target);
+  nbGroup = std::max(nbGroup, target.group + 1);
+
+  if (target.nbRange == 0) {
+    addRefBucket.push_back(sAddress);
+    addRefId.push_back(id);
+    return;
+  }
+
+  // Every 16 bits prefix covered by an interval, the bounds are big
+  // endian and address_t is read little endian from the hash160
+  vector<bool> seen(_64K, false);
+  for (int r = 0; r < target.nbRange; r++) {
+    uint32_t b0 = ((uint32_t)target.lo[r][0] << 8) | target.lo[r][1];
+    uint32_t b1 = ((uint32_t)target.hi[r][0] << 8) | target.hi[r][1];
+    for (uint32_t b = b0; b <= b1; b++) {
+      if (seen[b])
+        continue;
+      seen[b] = true;
+      addRefBucket.push_back((address_t)(((b & 0xFF) << 8) | (b >> 8)));
+      addRefId.push_back(id);
+    }
+  }
+
+}
+
+// ----------------------------------------------------------------------------
+
+// Stable counting sort of n items on their 16 bits prefix, fills the
+// bucket index and returns the order
+static vector<uint32_t> SortBucket(const vector<address_t> &key, vector<uint32_t> &bucket) {
+
+  uint32_t n = (uint32_t)key.size();
+  bucket.assign(_64K + 1, 0);
+  for (uint32_t i = 0; i < n; i++)
+    bucket[key[i] + 1]++;
+  for (int i = 0; i < _64K; i++)
+    bucket[i + 1] += bucket[i];
+
+  vector<uint32_t> pos(bucket.begin(), bucket.end() - 1);
+  vector<uint32_t> order(n);
+  for (uint32_t i = 0; i < n; i++)
+    order[pos[key[i]]++] = i;
+  return order;
+
+}
+
+// Run f(thread id) on nbThread threads
+template <typename F> static void ParallelRun(int nbThread, F f) {
+
+  vector<thread> threads;
+  for (int t = 1; t < nbThread; t++)
+    threads.push_back(thread(f, t));
+  f(0);
+  for (auto &th : threads)
+    th.join();
+
+}
+
+typedef struct {
+  uint8_t h[20];
+} HASH160;
+
+// Order inside a 16 bits bucket: 32 bits prefix (address_t, little endian)
+// as the second level lookup, then the remaining bytes
+static bool LessInBucket(const HASH160 &a, const HASH160 &b) {
+  addressl_t la = *(addressl_t *)a.h;
+  addressl_t lb = *(addressl_t *)b.h;
+  if (la != lb) return la < lb;
+  return memcmp(a.h + 4, b.h + 4, 16) < 0;
+}
+
+void TargetStore::Build(int nbThread) {
+
+  // Full addresses: radix pass on the 16 bits prefix (per thread
+  // histograms and scatter), then every bucket is sorted by a thread
+  uint32_t n = (uint32_t)(addHash160.size() / 20);
+  if (nbThread < 1 || n < 65536) nbThread = 1;
+  const HASH160 *in = (const HASH160 *)addHash160.data();
+
+  vector<vector<uint32_t>> hist(nbThread, vector<uint32_t>(_64K, 0));
+  ParallelRun(nbThread, [&](int t) {
+    uint32_t end = (uint32_t)(((uint64_t)n * (t + 1)) / nbThread);
+    for (uint32_t i = (uint32_t)(((uint64_t)n * t) / nbThread); i < end; i++)
+      hist[t][*(address_t *)in[i].h]++;
+  });
+
+  bucket.assign(_64K + 1, 0);
+  for (int b = 0; b < _64K; b++) {
+    uint32_t pos = bucket[b];
+    for (int t = 0; t < nbThread; t++) {
+      uint32_t c = hist[t][b];
+      hist[t][b] = pos;
+      pos += c;
+    }
+    bucket[b + 1] = pos;
+  }
+
+  hash160.resize((size_t)n * 20);
+  HASH160 *out = (HASH160 *)hash160.data();
+  ParallelRun(nbThread, [&](int t) {
+    uint32_t end = (uint32_t)(((uint64_t)n * (t + 1)) / nbThread);
+    for (uint32_t i = (uint32_t)(((uint64_t)n * t) / nbThread); i < end; i++)
+      out[hist[t][*(address_t *)in[i].h]++] = in[i];
+  });
+  vector<uint8_t>().swap(addHash160);
+  vector<vector<uint32_t>>().swap(hist);
+
+  // Buckets split in nbThread ranges of about n/nbThread items
+  vector<int> first(nbThread + 1, _64K);
+  first[0] = 0;
+  for (int b = 0, t = 1; b < _64K && t < nbThread; b++)
+    while (t < nbThread && bucket[b] >= (uint32_t)(((uint64_t)n * t) / nbThread))
+      first[t++] = b;
+  ParallelRun(nbThread, [&](int t) {
+    for (int b = first[t]; b < first[t + 1]; b++)
+      std::sort(out + bucket[b], out + bucket[b + 1], LessInBucket);
+  });
+  // Value initialized (zero)
+  vector<atomic<uint64_t>>(((size_t)n + 63) / 64).swap(found);
+  vector<atomic<uint8_t>>(nbGroup).swap(prefixFound);
+
+  // Prefix references
+  vector<uint32_t> order = SortBucket(addRefBucket, prefixBucket);
+  prefixRef.resize(order.size());
+  for (size_t i = 0; i < order.size(); i++)
+    prefixRef[i] = addRefId[order[i]];
+
+  vector<address_t>().swap(addRefBucket);
+  vector<uint32_t>().swap(addRefId);
+
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t TargetStore::GetLookup(std::vector<address_t> &used, std::vector<LADDRESS> &lookup, bool skipFound) {
+
+  used.clear();
+  lookup.clear();
+  uint32_t total = 0;
+
+  for (int i = 0; i < _64K; i++) {
+
+    // Prefixes of the bucket still searched
+    bool hasPrefix = false;
+    for (uint32_t j = prefixBucket[i]; j < prefixBucket[i + 1] && !hasPrefix; j++)
+      hasPrefix = !skipFound || !IsFound(GetPrefix(j));
+
+    LADDRESS lit;
+    lit.sAddress = (address_t)i;
+    // Already sorted by Build()
+    lit.lAddresses.reserve(bucket[i + 1] - bucket[i]);
+    for (uint32_t j = bucket[i]; j < bucket[i + 1]; j++)
+      if (!skipFound || !IsFound(j))
+        lit.lAddresses.push_back(*(addressl_t *)GetHash160(j));
+
+    if (lit.lAddresses.size() == 0 && !hasPrefix)
+      continue;
+
+    used.push_back((address_t)i);
+    total += (uint32_t)lit.lAddresses.size();
+    lookup.push_back(lit);
+
+  }
+
+  return total;
+
+}
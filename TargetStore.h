@@ -0,0 +1,162 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TARGETSTOREH
+#define TARGETSTOREH
+
+#include <string>
+#include <string.h>
+#include <vector>
+#include <stdint.h>
+#include <atomic>
+#include "ComputeEngine.h"
+
+// Max number of hash160 intervals of a prefix (one per address length)
+#define PREFIX_MAX_RANGE 4
+
+// Max number of case variants of a case insensitive prefix, longer
+// prefixes only expand their first letters
+#define PREFIX_MAX_VARIANT 64
+
+// Prefix target. A P2PKH/P2SH prefix is a set of hash160 intervals
+// [lo,hi] (big endian), only a hash160 equal to a bound needs the
+// address string. Without interval the address string is compared.
+// The variants of a case insensitive prefix share the group of the
+// input prefix, partial variants only cover its first letters.
+typedef struct {
+
+  std::string prefix;
+  int nbRange;
+  uint8_t lo[PREFIX_MAX_RANGE][20];
+  uint8_t hi[PREFIX_MAX_RANGE][20];
+  uint32_t group;
+  bool noCase;
+  bool partial;
+
+} PREFIX_TARGET;
+
+// Prefix match results
+#define PREFIX_NOMATCH 0
+#define PREFIX_MATCH   1
+#define PREFIX_CHECK   2
+
+// Search targets grouped by 16 bits prefix in flat arrays: the hash160
+// of the full addresses with a found bitset (20 bytes per full address),
+// and the prefixes referenced from every 16 bits bucket they cover.
+// The found flags are atomic, they can be read without the search mutex.
+class TargetStore {
+
+public:
+
+  TargetStore();
+
+  // Add targets, Build() must be called before any lookup
+  void AddFull(const uint8_t *hash160, size_t count = 1);
+  void AddPrefix(PREFIX_TARGET &target, address_t sAddress);
+  void Build(int nbThread = 1);
+  void Clear();
+
+  uint32_t GetNbFull();
+  uint32_t GetNbPrefix();
+
+  // Targets (full addresses and prefix groups) and targets found
+  uint32_t GetNbTarget();
+  uint32_t GetNbFound();
+
+  // Full addresses [begin,end) of the 16 bits prefix
+  inline void GetBucket(address_t sAddress, uint32_t &begin, uint32_t &end) {
+    begin = bucket[sAddress];
+    end = bucket[sAddress + 1];
+  }
+
+  inline const uint8_t *GetHash160(uint32_t i) {
+    return hash160.data() + (size_t)i * 20;
+  }
+
+  inline bool IsFound(uint32_t i) {
+    return (found[i >> 6].load(std::memory_order_relaxed) >> (i & 63)) & 1;
+  }
+
+  // True when not found before
+  inline bool SetFound(uint32_t i) {
+    uint64_t bit = 1ULL << (i & 63);
+    if (found[i >> 6].fetch_or(bit) & bit) return false;
+    nbFound++;
+    return true;
+  }
+
+  // Prefixes covering the 16 bits prefix, ids in [begin,end)
+  inline void GetPrefixBucket(address_t sAddress, uint32_t &begin, uint32_t &end) {
+    begin = prefixBucket[sAddress];
+    end = prefixBucket[sAddress + 1];
+  }
+
+  inline PREFIX_TARGET *GetPrefix(uint32_t j) {
+    return &prefixes[prefixRef[j]];
+  }
+
+  inline bool IsFound(PREFIX_TARGET *t) {
+    return prefixFound[t->group].load(std::memory_order_relaxed);
+  }
+
+  inline bool SetFound(PREFIX_TARGET *t) {
+    if (prefixFound[t->group].exchange(1)) return false;
+    nbFound++;
+    return true;
+  }
+
+  // PREFIX_MATCH, PREFIX_NOMATCH or PREFIX_CHECK (compare the address)
+  static inline int MatchPrefix(PREFIX_TARGET *t, const uint8_t *h) {
+    if (t->nbRange == 0)
+      return PREFIX_CHECK;
+    for (int r = 0; r < t->nbRange; r++) {
+      int l = memcmp(h, t->lo[r], 20);
+      int u = memcmp(h, t->hi[r], 20);
+      if (l > 0 && u < 0)
+        return t->partial ? PREFIX_CHECK : PREFIX_MATCH;
+      if (l == 0 || u == 0)
+        return PREFIX_CHECK;
+    }
+    return PREFIX_NOMATCH;
+  }
+
+  // Engine lookup tables: used 16 bits prefixes and sorted 32 bits
+  // prefixes of the full addresses, without the found targets if
+  // skipFound. Returns the number of 32 bits prefixes.
+  uint32_t GetLookup(std::vector<address_t> &used, std::vector<LADDRESS> &lookup, bool skipFound = false);
+
+private:
+
+  // Staging area filled by Add()
+  std::vector<uint8_t> addHash160;
+  std::vector<address_t> addRefBucket;
+  std::vector<uint32_t> addRefId;
+
+  std::vector<uint32_t> bucket;
+  std::vector<uint8_t> hash160;
+  std::vector<std::atomic<uint64_t>> found;
+  std::atomic<uint32_t> nbFound;
+
+  std::vector<PREFIX_TARGET> prefixes;
+  uint32_t nbGroup;
+  std::vector<std::atomic<uint8_t>> prefixFound;
+  std::vector<uint32_t> prefixBucket;
+  std::vector<uint32_t> prefixRef;
+
+};
+
+#endif // TARGETSTOREH
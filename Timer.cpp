@@ -60,6 +60,18 @@ double Timer::get_tick() {
 #endif
 }
 
+int Timer::getCoreNumber() {
+
+#ifdef WIN64
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  return sysinfo.dwNumberOfProcessors;
+#else
+  return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+}
+
 std::string Timer::getSeed(int size) {
 
   std::string ret;
@@ -130,6 +142,10 @@ std::string Timer::getSeed(int size) {
   return ret;
 }
 
+uint32_t Timer::getSeed32() {
+  return ::strtoul(getSeed(4).c_str(),NULL,16);
+}
+
 
 std::string Timer::getResult(char *unit, int nbTry, double t0, double t1) {
 
@@ -20,12 +20,12 @@
  */
 
 #include "Vanity.h"
+#include "Coordinator.h"
 #include "Base58.h"
 #include "Bech32.h"
 #include "hash/sha256.h"
 #include "hash/sha512.h"
 #include "IntGroup.h"
-#include "Wildcard.h"
 #include "Timer.h"
 #include "hash/ripemd160.h"
 #include <string.h>
@@ -33,12 +33,72 @@
 #include <algorithm>
 #include <thread>
 #include <atomic>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
 
-//Point Gn[GRP_SIZE / 2];
-//Point _2Gn;
+static const char* b58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+// Base58 decoded version|hash160|checksum with a valid checksum
+static bool isFullAddress(std::vector<unsigned char>& result) {
+
+	uint8_t chk[4];
+	if (result.size() != 25)
+		return false;
+	sha256_checksum(result.data(), 21, chk);
+	return memcmp(chk, result.data() + 21, 4) == 0;
+
+}
+
+// Empty target set
+static TARGET_SET* newTargetSet() {
+
+	TARGET_SET* set = new TARGET_SET();
+	set->targets.reset(new TargetStore());
+	set->nbAddress = 0;
+	set->onlyFull = true;
+	set->hasFilter = false;
+	return set;
+
+}
+
+// Hash160 of a full address of the search type, thread safe. False for
+// anything else (prefix, other type, invalid), left to initAddress.
+static bool decodeFullAddress(std::string& address, int searchType, uint8_t* h, std::vector<unsigned char>& result) {
+
+	if (address.length() == 0)
+		return false;
+
+	switch (address[0]) {
+	case '1':
+	case '3':
+		if (searchType != ((address[0] == '1') ? P2PKH : P2SH))
+			return false;
+		if (!DecodeBase58(address, result) || !isFullAddress(result))
+			return false;
+		memcpy(h, result.data() + 1, 20);
+		return true;
+	case 'b':
+	case 'B': {
+		if (searchType != BECH32)
+			return false;
+		std::string a(address);
+		std::transform(a.begin(), a.end(), a.begin(), ::tolower);
+		uint8_t witprog[40];
+		size_t witprog_len;
+		int witver;
+		if (strncmp(a.c_str(), "bc1q", 4) != 0 || !segwit_addr_decode(&witver, witprog, &witprog_len, "bc", a.c_str()) || witprog_len != 20)
+			return false;
+		memcpy(h, witprog, 20);
+		return true;
+	}
+	}
+	return false;
+
+}
 
 VanitySearch::VanitySearch(Secp256K1* secp, std::vector<std::string>& inputAddresses, int searchMode,
-	bool stop, std::string outputFile, uint32_t maxFound, BITCRACK_PARAM* bc, int batchSize):inputAddresses(inputAddresses)
+	bool stop, std::string outputFile, uint32_t maxFound, BITCRACK_PARAM* bc, int batchSize, TargetDB* db, bool caseSensitive):inputAddresses(inputAddresses)
 {
     this->batchSize = batchSize;
 	this->secp = secp;
@@ -49,127 +109,87 @@ VanitySearch::VanitySearch(Secp256K1* secp, std::vector<std::string>& inputAddre
 	this->maxFound = maxFound;	
 	this->searchType = -1;
 	this->bc = bc;	
+	this->checkpointFile = "";
+	this->checkpointInterval = 0;
+	this->resumeState = NULL;
+	this->nbFoundKey = 0;
+	this->workClient = NULL;
+	this->useEndo = false;
+	this->useFilter = false;
+	this->db = db;
+	this->caseSensitive = caseSensitive;
 	
-	addresses.clear();
-
-	// Create a 65536 items lookup table
-	ADDRESS_TABLE_ITEM t;
-	t.found = true;
-	t.items = NULL;
-	for (int i = 0; i < 65536; i++)
-		addresses.push_back(t);
-	
-	// Insert addresses
-	bool loadingProgress = (inputAddresses.size() > 1000);
-	if (loadingProgress)
-		fprintf(stdout, "[Building lookup16   0.0%%]\r");
-
-	nbAddress = 0;
-	onlyFull = true;
-
-	for (int i = 0; i < (int)inputAddresses.size(); i++) 
-	{
-		ADDRESS_ITEM it;
-		std::vector<ADDRESS_ITEM> itAddresses;
-
-		if (initAddress(inputAddresses[i], &it)) {
-			bool* found = new bool;
-			*found = false;
-			it.found = found;
-			itAddresses.push_back(it);
+	this->watchInput = false;
+	this->inputTime = 0;
+	this->inputTimeSeen = 0;
+	this->reloadDone = false;
+	this->reloadPrune = false;
+	this->pruneRequest = false;
+	this->allFound = false;
+	this->nbDBFound = 0;
+
+	TARGET_SET* set = newTargetSet();
+
+	if (db) {
+
+		// Hash160 of a target database, the mapped file is the second level lookup
+		if (db->GetSize() > 0xFFFFFFFFULL) {
+			fprintf(stderr, "[ERROR] VanitySearch: too many targets in database\n");
+			exit(-1);
 		}
+		searchType = db->GetType();
+		std::vector<std::atomic<uint8_t>>(db->GetSize()).swap(dbFound);
+		buildDBLookup(set, false);
 
-		if (itAddresses.size() > 0) 
-		{
-			// Add the item to all correspoding addresses in the lookup table
-			for (int j = 0; j < (int)itAddresses.size(); j++) 
-			{
-				address_t p = itAddresses[j].sAddress;
-
-				if (addresses[p].items == NULL) {
-					addresses[p].items = new std::vector<ADDRESS_ITEM>();
-					addresses[p].found = false;
-					usedAddress.push_back(p);
-				}
-				(*addresses[p].items).push_back(itAddresses[j]);
-			}
-			onlyFull &= it.isFull;
-			nbAddress++;
-		}
-
-		if (loadingProgress && i % 1000 == 0)
-			fprintf(stdout, "[Building lookup16 %5.1f%%]\r", (((double)i) / (double)(inputAddresses.size() - 1)) * 100.0);
 	}
+	else {
+
+		loadTargets(inputAddresses, set, inputAddresses.size() > 1000);
 
-	if (loadingProgress)
-		fprintf(stdout, "\n");
+	}
+	targetSet.reset(set);
 
-	if (nbAddress == 0) 
+	if (set->nbAddress == 0) 
 	{
 		fprintf(stderr, "[ERROR] VanitySearch: nothing to search !\n");
 		exit(-1);
 	}
 
+	// Segwit addresses only use compressed keys
+	if (searchType != P2PKH && this->searchMode != SEARCH_COMPRESSED) {
+		fprintf(stdout, "Warning, P2SH and BECH32 addresses use compressed keys, searching compressed only\n");
+		this->searchMode = SEARCH_COMPRESSED;
+	}
+
 	// Second level lookup
 	uint32_t unique_sAddress = 0;
 	uint32_t minI = 0xFFFFFFFF;
 	uint32_t maxI = 0;
-	for (int i = 0; i < (int)addresses.size(); i++) 
+	for (int i = 0; i < (int)set->usedAddressL.size(); i++) 
 	{
-		
-		if (addresses[i].items) 
-		{
-			
-			LADDRESS lit;
-			lit.sAddress = i;
-			if (addresses[i].items) 
-			{
-				for (int j = 0; j < (int)addresses[i].items->size(); j++) 
-				{
-					lit.lAddresses.push_back((*addresses[i].items)[j].lAddress);
-					
-				}
-			}
-
-			std::sort(lit.lAddresses.begin(), lit.lAddresses.end());
-			usedAddressL.push_back(lit);
-			if ((uint32_t)lit.lAddresses.size() > maxI) maxI = (uint32_t)lit.lAddresses.size();
-			if ((uint32_t)lit.lAddresses.size() < minI) minI = (uint32_t)lit.lAddresses.size();
-			unique_sAddress++;
-		}
-
-		if (loadingProgress)
-			fprintf(stdout, "[Building lookup32 %.1f%%]\r", ((double)i * 100.0) / (double)addresses.size());
+		uint32_t size = (uint32_t)set->usedAddressL[i].lAddresses.size();
+		if (size > maxI) maxI = size;
+		if (size < minI) minI = size;
+		unique_sAddress++;
 	}
-
-	if (loadingProgress)
-		fprintf(stdout, "\n");
 	
-	std::string searchInfo = std::string(searchModes[searchMode]);
-	if (nbAddress < 10) 
+	std::string searchInfo = std::string(searchModes[this->searchMode]);
+	if (db)
+	{
+		fprintf(stdout, "Search: %d (Lookup size %d, target database) [%s]\n", set->nbAddress, (int)set->usedAddress.size(), searchInfo.c_str());
+	}
+	else if (set->nbAddress < 10) 
 	{	
-		for (int i = 0; i < nbAddress; i++)
+		for (int i = 0; i < (int)set->nbAddress; i++)
 		{
 			fprintf(stdout, "Search: %s [%s]\n", inputAddresses[i].c_str(), searchInfo.c_str());
 		}
 	}
 	else 
 	{		
-		fprintf(stdout, "Search: %d (Lookup size %d,[%d,%d]) [%s]\n", nbAddress, unique_sAddress, minI, maxI, searchInfo.c_str());
+		fprintf(stdout, "Search: %d (Lookup size %d,[%d,%d]) [%s]\n", set->nbAddress, unique_sAddress, minI, maxI, searchInfo.c_str());
 	}
 
-	//// Compute Generator table G[n] = (n+1)*G
-	//Point g = secp->G;
-	//Gn[0] = g;
-	//g = secp->DoubleDirect(g);
-	//Gn[1] = g;
-	//for (int i = 2; i < GRP_SIZE / 2; i++) {
-	//	g = secp->AddDirect(g, secp->G);
-	//	Gn[i] = g;
-	//}
-	//// _2Gn = CPU_GRP_SIZE*G
-	//_2Gn = secp->DoubleDirect(Gn[GRP_SIZE / 2 - 1]);
-
 	// Constant for endomorphism
 	// if a is a nth primitive root of unity, a^-1 is also a nth primitive root.
 	// beta^3 = 1 mod p implies also beta^2 = beta^-1 mop (by multiplying both side by beta^-1)
@@ -201,6 +221,108 @@ bool VanitySearch::isSingularAddress(std::string pref) {
 	return only1;
 }
 
+// Store the interval [l,u] of 25 bytes numbers as hash160 bounds
+static void setPrefixRange(Int& l, Int& u, Int& base, uint8_t* lo, uint8_t* hi) {
+
+	l.Sub(&base);
+	u.Sub(&base);
+	l.ShiftR(32);
+	u.ShiftR(32);
+	for (int j = 0; j < 20; j++) {
+		lo[j] = l.GetByte(19 - j);
+		hi[j] = u.GetByte(19 - j);
+	}
+
+}
+
+// Hash160 intervals of the P2PKH/P2SH addresses starting with prefix, one
+// per address length. The address is the base58 of the 25 bytes number
+// version|hash160|checksum, a P2PKH version byte is the leading '1' and
+// every other leading '1' is a leading zero byte of the hash160.
+static int getPrefixRange(std::string& prefix, int searchType, uint8_t lo[][20], uint8_t hi[][20]) {
+
+	std::string digits;
+	Int base;
+	Int nMin;
+	Int nMax;
+	base.SetInt32(0);
+
+	if (searchType == P2PKH) {
+		if (prefix.length() < 2)
+			return 0;
+		int nbZero = 0;
+		while (1 + nbZero < (int)prefix.length() && prefix[1 + nbZero] == '1')
+			nbZero++;
+		if (nbZero > 20)
+			return 0;
+		digits = prefix.substr(1 + nbZero);
+		nMax.SetInt32(1);
+		nMax.ShiftL(8 * (24 - nbZero));
+		nMax.SubOne();
+		if (digits.length() == 0) {
+			// Only '1', at least nbZero zero bytes
+			Int l;
+			l.SetInt32(0);
+			setPrefixRange(l, nMax, base, lo[0], hi[0]);
+			return 1;
+		}
+		nMin.SetInt32(1);
+		nMin.ShiftL(8 * (23 - nbZero));
+	}
+	else if (searchType == P2SH) {
+		digits = prefix;
+		base.SetInt32(5);
+		base.ShiftL(192);
+		nMin.Set(&base);
+		Int one;
+		one.SetInt32(1);
+		one.ShiftL(192);
+		nMax.Add(&base, &one);
+		nMax.SubOne();
+	}
+	else {
+		return 0;
+	}
+
+	Int val;
+	val.SetInt32(0);
+	for (int i = 0; i < (int)digits.length(); i++) {
+		const char* c = strchr(b58, digits[i]);
+		if (c == NULL)
+			return 0;
+		val.Mult((uint64_t)58);
+		val.Add((uint64_t)(c - b58));
+	}
+
+	// [val*58^k, (val+1)*58^k - 1] for k more digits
+	int nbRange = 0;
+	Int scale;
+	scale.SetInt32(1);
+	for (int k = 0; nbRange < PREFIX_MAX_RANGE; k++) {
+
+		Int l(&val);
+		l.Mult(&scale);
+		if (l.IsGreater(&nMax))
+			break;
+		Int u(&val);
+		u.AddOne();
+		u.Mult(&scale);
+		u.SubOne();
+		scale.Mult((uint64_t)58);
+		if (u.IsLower(&nMin))
+			continue;
+
+		if (l.IsLower(&nMin)) l.Set(&nMin);
+		if (u.IsGreater(&nMax)) u.Set(&nMax);
+		setPrefixRange(l, u, base, lo[nbRange], hi[nbRange]);
+		nbRange++;
+
+	}
+
+	return nbRange;
+
+}
+
 bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 
 	std::vector<unsigned char> result;
@@ -208,11 +330,16 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 	int nbDigit = 0;
 	bool wrong = false;
 
+	it->nbRange = 0;
+	it->rangePartial = false;
+	it->isPattern = false;
+
 	if (address.length() < 2) {
 		fprintf(stdout, "Ignoring address \"%s\" (too short)\n", address.c_str());
 		return false;
 	}
 
+	bool isPattern = (address.find_first_of("?*") != std::string::npos);
 	int aType = -1;
 
 	switch (address.data()[0]) {
@@ -228,6 +355,12 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 		if (strncmp(address.c_str(), "bc1q", 4) == 0)
 			aType = BECH32;
 		break;
+	case '?':
+	case '*':
+		// Pattern starting with a wildcard, type of the other inputs
+		if (isPattern)
+			aType = (searchType == -1) ? P2PKH : searchType;
+		break;
 	}
 
 	if (aType == -1) {
@@ -241,6 +374,32 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 		return false;
 	}
 
+	if (isPattern) {
+
+		// Wildcard pattern, matched on the address string (checkAddrSSE)
+		size_t start = (aType == BECH32 && strncmp(address.c_str(), "bc1q", 4) == 0) ? 4 : 0;
+		const char* alphabet = (aType == BECH32) ? "qpzry9x8gf2tvdw0s3jn54khce6mua7l" : b58;
+		for (size_t i = start; i < address.length(); i++) {
+			char c = address[i];
+			if (c == '?' || c == '*' || strchr(alphabet, c))
+				continue;
+			if (aType == BECH32)
+				fprintf(stdout, "Ignoring address \"%s\" (Only \"023456789acdefghjklmnpqrstuvwxyz\" allowed)\n", address.c_str());
+			else
+				fprintf(stdout, "Ignoring address \"%s\" (0, I, O and l not allowed)\n", address.c_str());
+			return false;
+		}
+
+		it->isPattern = true;
+		it->isFull = false;
+		it->sAddress = 0;
+		it->lAddress = 0;
+		it->address = address; // Store a copy of the address string
+		it->addressLength = (int)address.length();
+		return true;
+
+	}
+
 	if (aType == BECH32) {
 
 		// BECH32
@@ -269,8 +428,8 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 			return false;
 		}
 
-		if (address.length() >= 36) {
-			fprintf(stdout, "Ignoring address \"%s\" (too long, length>36 )\n", address.c_str());
+		if (address.length() >= 42) {
+			fprintf(stdout, "Ignoring address \"%s\" (too long, length>=42 )\n", address.c_str());
 			return false;
 		}
 
@@ -288,6 +447,22 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 		it->address = address; // Store a copy of the address string
 		it->addressLength = (int)address.length();
 
+		// The 32 characters after "bc1q" are the 5 bits groups of the hash160,
+		// the prefix is the interval of the hash160 starting with its bits.
+		// Characters of the checksum are left to the address string.
+		int nbBit = 5 * std::min((int)address.length() - 4, 32);
+		memcpy(it->rangeLo[0], data, 20);
+		memcpy(it->rangeHi[0], data, 20);
+		if (nbBit < 160) {
+			int n = nbBit / 8;
+			it->rangeLo[0][n] &= (uint8_t)(0xFF00 >> (nbBit % 8));
+			it->rangeHi[0][n] |= (uint8_t)(0xFF >> (nbBit % 8));
+			memset(it->rangeLo[0] + n + 1, 0x00, 19 - n);
+			memset(it->rangeHi[0] + n + 1, 0xFF, 19 - n);
+		}
+		it->nbRange = 1;
+		it->rangePartial = (address.length() > 36);
+
 		return true;
 	}
 	else {
@@ -300,8 +475,9 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 			return false;
 		}
 
-		// Try to attack a full address ?
-		if (result.size() > 21) {
+		// Try to attack a full address ? (version|hash160|checksum, a long
+		// prefix may also decode to 25 bytes but fails the checksum)
+		if (isFullAddress(result)) {
 			
 			it->isFull = true;
 			memcpy(it->hash160, result.data() + 1, 20);
@@ -325,6 +501,7 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 			it->lAddress = 0;
 			it->address = address; // Store a copy of the address string
 			it->addressLength = (int)address.length();
+			it->nbRange = getPrefixRange(address, searchType, it->rangeLo, it->rangeHi);
 			return true;
 		}
 
@@ -363,43 +540,193 @@ bool VanitySearch::initAddress(std::string& address, ADDRESS_ITEM* it) {
 		it->lAddress = 0;
 		it->address = address; // Store a copy of the address string
 		it->addressLength = (int)address.length();
+		it->nbRange = getPrefixRange(address, searchType, it->rangeLo, it->rangeHi);
 
 		return true;
 	}
 }
 
-void VanitySearch::enumCaseUnsentiveAddress(std::string s, std::vector<std::string>& list) {
+// Case variants of the first characters of s (Base58 only has one case
+// of 'i', 'l' and 'o'), at most PREFIX_MAX_VARIANT. Returns the length of
+// the variants, s.length() when s is fully expanded, or -1 if a character
+// is not Base58.
+int VanitySearch::enumCaseUnsentiveAddress(std::string s, std::vector<std::string>& list) {
+
+	list.clear();
+	list.push_back(s.substr(0, 1));
+
+	int length = 1;
+	for (; length < (int)s.length(); length++) {
+
+		char lc = (char)tolower(s[length]);
+		char uc = (char)toupper(s[length]);
+		char alt[2];
+		int nbAlt = 0;
+		if (strchr(b58, lc)) alt[nbAlt++] = lc;
+		if (uc != lc && strchr(b58, uc)) alt[nbAlt++] = uc;
+		if (nbAlt == 0)
+			return -1;
+		if (list.size() * nbAlt > PREFIX_MAX_VARIANT)
+			break;
+
+		size_t nb = list.size();
+		for (size_t i = 0; i < nb; i++) {
+			if (nbAlt == 2)
+				list.push_back(list[i] + alt[1]);
+			list[i].push_back(alt[0]);
+		}
+
+	}
 
-	char letter[64];
-	int letterpos[64];
-	int nbLetter = 0;
-	int length = (int)s.length();
+	// Remaining characters must be valid too
+	for (int i = length; i < (int)s.length(); i++)
+		if (!strchr(b58, tolower(s[i])) && !strchr(b58, toupper(s[i])))
+			return -1;
 
-	for (int i = 1; i < length; i++) {
-		char c = s.data()[i];
-		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
-			letter[nbLetter] = tolower(c);
-			letterpos[nbLetter] = i;
-			nbLetter++;
-		}
+	return length;
+
+}
+
+// Add an input address/prefix to the target store
+bool VanitySearch::addTarget(std::string& address, uint32_t& nbGroup, TARGET_SET* set) {
+
+	ADDRESS_ITEM it;
+	std::vector<unsigned char> result;
+
+	// Case insensitive prefix, full addresses stay case sensitive
+	if (!caseSensitive && (address[0] == '1' || address[0] == '3') && address.find_first_of("?*") == std::string::npos &&
+		!(DecodeBase58(address, result) && isFullAddress(result))) {
+		if (!initCaseInsensitive(address, nbGroup, set))
+			return false;
+		nbGroup++;
+		set->onlyFull = false;
+		set->nbAddress++;
+		return true;
+	}
+
+	if (!initAddress(address, &it))
+		return false;
+
+	if (it.isPattern) {
+		set->patterns.Add(it.address);
+		set->onlyFull = false;
+		set->nbAddress++;
+		return true;
 	}
 
-	int total = 1 << nbLetter;
+	if (it.isFull) {
+		set->targets->AddFull(it.hash160);
+	}
+	else {
+		PREFIX_TARGET t;
+		t.prefix = it.address;
+		t.nbRange = it.nbRange;
+		memcpy(t.lo, it.rangeLo, sizeof(t.lo));
+		memcpy(t.hi, it.rangeHi, sizeof(t.hi));
+		t.group = nbGroup++;
+		t.noCase = false;
+		t.partial = it.rangePartial;
+		set->targets->AddPrefix(t, it.sAddress);
+	}
+	set->onlyFull &= it.isFull;
+	set->nbAddress++;
+	return true;
 
-	for (int i = 0; i < total; i++) {
+}
 
-		char tmp[64];
-		strcpy(tmp, s.c_str());
+// Build a target set: the full addresses are decoded on all cores, the
+// prefixes (and the first address, which sets the search type) are added
+// in input order
+void VanitySearch::loadTargets(std::vector<std::string>& inputs, TARGET_SET* set, bool verbose) {
+
+	double tDecode = Timer::get_tick();
+	int nbThread = std::max(1, (int)std::thread::hardware_concurrency());
+	size_t nbInput = inputs.size();
+	uint32_t nbGroup = 0;
+	size_t i0 = 0;
+	while (i0 < nbInput && searchType == -1)
+		addTarget(inputs[i0++], nbGroup, set);
+
+	std::vector<std::vector<uint8_t>> fullHash(nbThread);
+	std::vector<std::vector<size_t>> others(nbThread);
+	std::vector<std::thread> decoders;
+	for (int t = 0; t < nbThread; t++) {
+		decoders.push_back(std::thread([&, t]() {
+			size_t begin = i0 + ((nbInput - i0) * t) / nbThread;
+			size_t end = i0 + ((nbInput - i0) * (t + 1)) / nbThread;
+			std::vector<unsigned char> result;
+			uint8_t h[20];
+			for (size_t i = begin; i < end; i++) {
+				if (decodeFullAddress(inputs[i], searchType, h, result))
+					fullHash[t].insert(fullHash[t].end(), h, h + 20);
+				else
+					others[t].push_back(i);
+			}
+		}));
+	}
+	for (int t = 0; t < nbThread; t++)
+		decoders[t].join();
+
+	for (int t = 0; t < nbThread; t++) {
+		size_t nb = fullHash[t].size() / 20;
+		set->targets->AddFull(fullHash[t].data(), nb);
+		set->nbAddress += (uint32_t)nb;
+		std::vector<uint8_t>().swap(fullHash[t]);
+	}
+	for (int t = 0; t < nbThread; t++)
+		for (size_t i = 0; i < others[t].size(); i++)
+			addTarget(inputs[others[t][i]], nbGroup, set);
 
-		for (int j = 0; j < nbLetter; j++) {
-			int mask = 1 << j;
-			if (mask & i) tmp[letterpos[j]] = toupper(letter[j]);
-			else         tmp[letterpos[j]] = letter[j];
-		}
+	double tSort = Timer::get_tick();
+	set->targets->Build(nbThread);
+	double tTables = Timer::get_tick();
+
+	if (set->patterns.GetSize() > 0)
+		set->patterns.Build();
+
+	set->targets->GetLookup(set->usedAddress, set->usedAddressL);
+	if (verbose)
+		fprintf(stdout, "[Building lookup] decode %.3f s, sort %.3f s, tables %.3f s (%d threads)\n",
+			tSort - tDecode, tTables - tSort, Timer::get_tick() - tTables, nbThread);
+
+}
+
+// Case insensitive P2PKH/P2SH prefix, one target per case variant
+bool VanitySearch::initCaseInsensitive(std::string& prefix, uint32_t group, TARGET_SET* set) {
+
+	int aType = (prefix[0] == '1') ? P2PKH : P2SH;
+	if (searchType == -1) searchType = aType;
+	if (aType != searchType) {
+		fprintf(stdout, "Ignoring address \"%s\" (P2PKH, P2SH or BECH32 allowed at once)\n", prefix.c_str());
+		return false;
+	}
+
+	std::vector<std::string> variants;
+	int length = enumCaseUnsentiveAddress(prefix, variants);
+	if (length < 0) {
+		fprintf(stdout, "Ignoring address \"%s\" (0 not allowed)\n", prefix.c_str());
+		return false;
+	}
 
-		list.push_back(std::string(tmp));
+	int nbVariant = 0;
+	for (int i = 0; i < (int)variants.size(); i++) {
+		PREFIX_TARGET t;
+		t.prefix = prefix;
+		t.group = group;
+		t.noCase = true;
+		t.partial = (length < (int)prefix.length());
+		t.nbRange = getPrefixRange(variants[i], searchType, t.lo, t.hi);
+		if (t.nbRange == 0)
+			continue;
+		set->targets->AddPrefix(t, 0);
+		nbVariant++;
+	}
 
+	if (nbVariant == 0) {
+		fprintf(stdout, "Ignoring address \"%s\" (Unreachable)\n", prefix.c_str());
+		return false;
 	}
+	return true;
 
 }
 
@@ -423,6 +750,12 @@ void VanitySearch::output(const std::vector<std::tuple<std::string, std::string,
   }
   fflush(stdout);
 
+  // Report to the coordinator when working for one
+  if (workClient) {
+    for (const auto& key : foundKeys)
+      workClient->Found(std::get<0>(key), std::get<1>(key), std::get<2>(key));
+  }
+
   // Get mutex with timeout
   bool gotMutex = false;
 #ifdef WIN64
@@ -497,22 +830,33 @@ bool VanitySearch::checkPrivKey(std::string addr, Int& key, int32_t incr, int en
     Point p;
     std::string chkAddr;
 
+    // A negative incr is the symmetric point (x,-y) = -(key + |incr|)*G
     k.Set(&key);
-    if (incr != 0) {
-        Int i;
-        i.SetInt32(incr);
-        k.Add(&i);
+    if (incr < 0) {
+        k.Add((uint64_t)(-incr));
+        k.Neg();
+        k.Add(&secp->order);
+    } else {
+        k.Add((uint64_t)incr);
     }
 
     if (endomorphism == 1) {
-        k.ModMulK1(&lambda);
+        k.ModMulK1order(&lambda);
     } else if (endomorphism == 2) {
-        k.ModMulK1(&lambda2);
+        k.ModMulK1order(&lambda2);
     }
 
     p = secp->ComputePublicKey(&k);
     chkAddr = secp->GetAddress(searchType, mode, p);
 
+    // incr 0 has no sign, it may also be the symmetric point
+    if (chkAddr != addr && incr == 0) {
+        k.Neg();
+        k.Add(&secp->order);
+        p = secp->ComputePublicKey(&k);
+        chkAddr = secp->GetAddress(searchType, mode, p);
+    }
+
     if (chkAddr == addr) {
         foundKeys.push_back({addr, secp->GetPrivAddress(mode, k), k.GetBase16(), secp->GetPublicKeyHex(mode, p)});
         return true;
@@ -526,114 +870,166 @@ void VanitySearch::updateFound() {
         foundKeys.clear();
     }
 }
-void VanitySearch::checkAddrSSE(uint8_t* h1, uint8_t* h2, uint8_t* h3, uint8_t* h4,
-	int32_t incr1, int32_t incr2, int32_t incr3, int32_t incr4,
-	Int& key, int endomorphism, bool mode) {
 
-	std::vector<std::string> addr = secp->GetAddress(searchType, mode, h1, h2, h3, h4);
+// Wildcard patterns, the addresses are encoded 16 at a time (checksum
+// kernels of the CPU)
+void VanitySearch::checkAddrSSE(TARGET_SET* set, ITEM* items, Int* keys, int n) {
 
-	for (int i = 0; i < (int)inputAddresses.size(); i++) {
+	char a[16][ADDRESS_SIZE];
+	char* addr[16];
+	uint8_t* h[16];
+	for (int j = 0; j < 16; j++)
+		addr[j] = a[j];
 
-		if (Wildcard::match(addr[0].c_str(), inputAddresses[i].c_str())) {
+	for (int i = 0; i < n && !endOfSearch; i += 16) {
 
-			// Found it !      
-			if (checkPrivKey(addr[0], key, incr1, endomorphism, mode)) {
-				nbFoundKey++;
-				//patternFound[i] = true;
-				updateFound();
-			}
-		}
-
-		if (Wildcard::match(addr[1].c_str(), inputAddresses[i].c_str())) {
+		int m = std::min(16, n - i);
+		for (int j = 0; j < m; j++)
+			h[j] = items[i + j].hash;
+		secp->GetAddress(searchType, true, h, addr, m);
 
-			// Found it !      
-			if (checkPrivKey(addr[1], key, incr2, endomorphism, mode)) {
-				nbFoundKey++;
-				//patternFound[i] = true;
-				updateFound();
-			}
-		}
+		for (int j = 0; j < m; j++) {
 
-		if (Wildcard::match(addr[2].c_str(), inputAddresses[i].c_str())) {
+			if (set->patterns.Match(addr[j]) < 0)
+				continue;
 
-			// Found it !      
-			if (checkPrivKey(addr[2], key, incr3, endomorphism, mode)) {
+			// Found it !
+			ITEM& it = items[i + j];
+			LOCK(mutex);
+			if (checkPrivKey(std::string(addr[j]), keys[i + j], it.incr, it.endo, it.mode)) {
 				nbFoundKey++;
-				//patternFound[i] = true;
 				updateFound();
 			}
-		}
-
-		if (Wildcard::match(addr[3].c_str(), inputAddresses[i].c_str())) {
+			UNLOCK(mutex);
 
-			// Found it !      
-			if (checkPrivKey(addr[3], key, incr4, endomorphism, mode)) {
-				nbFoundKey++;
-				//patternFound[i] = true;
-				updateFound();
-			}
 		}
+
 	}
+
 }
 
-void VanitySearch::checkAddr(int prefIdx, uint8_t* hash160, Int& key, int32_t incr, int endomorphism, bool mode) {
-	
-	std::vector<ADDRESS_ITEM>* pi = addresses[prefIdx].items;	
+// Address starts with the prefix of the target (case folded for -c)
+static bool comparePrefix(const char* addr, PREFIX_TARGET* t) {
+
+	size_t length = t->prefix.length();
+	if (!t->noCase)
+		return strncmp(addr, t->prefix.c_str(), length) == 0;
+	for (size_t i = 0; i < length; i++)
+		if (tolower(addr[i]) != tolower(t->prefix[i]))
+			return false;
+	return true;
 
+}
 
-	if (onlyFull) {
+// A new target is found with -stop (under mutex): end the search when it
+// was the last one, otherwise drop it from the lookup tables. Wildcard
+// patterns are never dropped, they are searched until the end.
+void VanitySearch::targetFound(TARGET_SET* set) {
 
-		// Full addresses
-		for (int i = 0; i < (int)pi->size(); i++) {
+	TargetStore* targets = set->targets.get();
+	bool last = db ? nbDBFound == dbFound.size() : targets->GetNbFound() == targets->GetNbTarget();
+	if (last && set->patterns.GetSize() == 0) {
+		allFound = true;
+		endOfSearch = true;
+	}
+	else {
+		pruneRequest = true;
+	}
 
-			if (stopWhenFound && *((*pi)[i].found))
-				continue;
+}
 
-			if (ripemd160_comp_hash((*pi)[i].hash160, hash160)) {
+void VanitySearch::checkAddr(TARGET_SET* set, int prefIdx, uint8_t* hash160, Int& key, int32_t incr, int endomorphism, bool mode) {
 
-				// Found it !
-				*((*pi)[i].found) = true;
-				// You believe it ?
-				if (checkPrivKey(secp->GetAddress(searchType, mode, hash160), key, incr, endomorphism, mode)) {
-					nbFoundKey++;
-					updateFound();
-				}
+	if (db) {
 
-			}
+		int64_t idx = db->Find(hash160);
+		if (idx < 0 || (stopWhenFound && dbFound[idx]))
+			return;
 
+		LOCK(mutex);
+		if (!dbFound[idx].exchange(1)) {
+			nbDBFound++;
+			if (stopWhenFound)
+				targetFound(set);
+		}
+		if (checkPrivKey(secp->GetAddress(searchType, mode, hash160), key, incr, endomorphism, mode)) {
+			nbFoundKey++;
+			updateFound();
 		}
+		UNLOCK(mutex);
+		return;
 
 	}
-	else {
-		char a[64];
 
-		std::string addr = secp->GetAddress(searchType, mode, hash160);
+	uint32_t begin, end;
 
-		for (int i = 0; i < (int)pi->size(); i++) {
+	// Full addresses
+	TargetStore& targets = *set->targets;
+	targets.GetBucket((address_t)prefIdx, begin, end);
+	for (uint32_t i = begin; i < end; i++) {
 
-			if (stopWhenFound && *((*pi)[i].found))
-				continue;
-
-		std::string currentAddr(addr.c_str(), (*pi)[i].addressLength);
-		
-		if (currentAddr == std::string((*pi)[i].address, (*pi)[i].addressLength)) {
+		if (stopWhenFound && targets.IsFound(i))
+			continue;
 
-				// Found it !
-				*((*pi)[i].found) = true;
-				if (checkPrivKey(addr, key, incr, endomorphism, mode)) {
-					nbFoundKey++;
-					updateFound();
-				}
+		if (ripemd160_comp_hash((uint8_t*)targets.GetHash160(i), hash160)) {
 
+			// Found it !
+			// You believe it ?
+			LOCK(mutex);
+			if (targets.SetFound(i) && stopWhenFound)
+				targetFound(set);
+			if (checkPrivKey(secp->GetAddress(searchType, mode, hash160), key, incr, endomorphism, mode)) {
+				nbFoundKey++;
+				updateFound();
 			}
+			UNLOCK(mutex);
 
 		}
 
 	}
 
+	// Prefixes, the address is only encoded on a match or on an interval bound
+	targets.GetPrefixBucket((address_t)prefIdx, begin, end);
+	for (uint32_t j = begin; j < end; j++) {
+
+		PREFIX_TARGET* t = targets.GetPrefix(j);
+		if (stopWhenFound && targets.IsFound(t))
+			continue;
+
+		int match = TargetStore::MatchPrefix(t, hash160);
+		if (match == PREFIX_NOMATCH)
+			continue;
+
+		char addr[ADDRESS_SIZE];
+		char* pAddr = addr;
+		secp->GetAddress(searchType, mode, &hash160, &pAddr, 1);
+		if (match == PREFIX_CHECK && !comparePrefix(addr, t))
+			continue;
+
+		// Found it !
+		LOCK(mutex);
+		if (targets.SetFound(t) && stopWhenFound)
+			targetFound(set);
+		if (checkPrivKey(std::string(addr), key, incr, endomorphism, mode)) {
+			nbFoundKey++;
+			updateFound();
+		}
+		UNLOCK(mutex);
+
+	}
 
 }
 
+#ifdef WIN64
+DWORD WINAPI _FindKeyCPU(LPVOID lpParam) {
+#else
+void* _FindKeyCPU(void* lpParam) {
+#endif
+	TH_PARAM* p = (TH_PARAM*)lpParam;
+	p->obj->FindKeyCPU(p);
+	return 0;
+}
+
 #ifdef WIN64
 DWORD WINAPI _FindKeyGPU(LPVOID lpParam) {
 #else
@@ -653,8 +1049,7 @@ void VanitySearch::checkAddresses(bool compressed, Int key, int i, Point p1) {
 	// Point
 	secp->GetHash160(searchType, compressed, p1, h0);
 	address_t pr0 = *(address_t*)h0;
-	if (addresses[pr0].items)
-		checkAddr(pr0, h0, key, i, 0, compressed);
+	checkAddr(std::atomic_load(&targetSet).get(), pr0, h0, key, i, 0, compressed);
 }
 
 
@@ -679,14 +1074,55 @@ void VanitySearch::checkAddressesSSE(bool compressed, Int key, int i, Point p1,
 	pr2 = *(address_t*)h2;
 	pr3 = *(address_t*)h3;
 
-	if (addresses[pr0].items)
-		checkAddr(pr0, h0, key, i, 0, compressed);
-	if (addresses[pr1].items)
-		checkAddr(pr1, h1, key, i + 1, 0, compressed);
-	if (addresses[pr2].items)
-		checkAddr(pr2, h2, key, i + 2, 0, compressed);
-	if (addresses[pr3].items)
-		checkAddr(pr3, h3, key, i + 3, 0, compressed);	
+	std::shared_ptr<TARGET_SET> set = std::atomic_load(&targetSet);
+	checkAddr(set.get(), pr0, h0, key, i, 0, compressed);
+	checkAddr(set.get(), pr1, h1, key, i + 1, 0, compressed);
+	checkAddr(set.get(), pr2, h2, key, i + 2, 0, compressed);
+	checkAddr(set.get(), pr3, h3, key, i + 3, 0, compressed);	
+}
+
+void VanitySearch::getCPURange(int thId, Int& rangeStart, Int& rangeEnd) {
+
+	// GPU threads come first, then each CPU thread takes CPU_LANE_WEIGHT
+	// GPU thread slices. The last CPU thread also gets the division remainder.
+	uint64_t weight = (nbGPULane > 0) ? CPU_LANE_WEIGHT : 1;
+	uint64_t nbLane = (uint64_t)nbGPULane + weight * (uint64_t)nbCPUThread;
+
+	Int taskSize;
+	Int laneSize;
+	Int n;
+
+	taskSize.Set(&bc->ksFinish);
+	taskSize.Sub(&bc->ksStart);
+	taskSize.AddOne();
+	n.SetInt32((uint32_t)nbLane);
+	laneSize.Set(&taskSize);
+	laneSize.Div(&n);
+
+	rangeStart.Set(&laneSize);
+	rangeStart.Mult((uint64_t)nbGPULane + weight * (uint64_t)thId);
+	rangeStart.Add(&bc->ksStart);
+
+	if (thId == nbCPUThread - 1) {
+		rangeEnd.Set(&bc->ksFinish);
+	} else {
+		rangeEnd.Set(&laneSize);
+		rangeEnd.Mult(weight);
+		rangeEnd.Add(&rangeStart);
+		rangeEnd.SubOne();
+	}
+}
+
+void VanitySearch::FindKeyCPU(TH_PARAM* ph) {
+
+	// One lane per CPU thread, the range is set by Search()
+	CPUEngine g(secp, ph->nbLane, maxFound);
+	g.SetEndomorphism(useEndo);
+	g.SetTargetDB(db);
+	uint64_t nbLaunch = getResumeLaunch(ph, g.GetNbThread(), g.GetStepSize(), 0);
+
+	FindKey(ph, &g, &g, nbLaunch);
+
 }
 
 void VanitySearch::getGPUStartingKeys(Int& tRangeStart, Int& tRangeEnd, int groupSize, int nbThread, Point *p, uint64_t Progress) {
@@ -698,12 +1134,25 @@ void VanitySearch::getGPUStartingKeys(Int& tRangeStart, Int& tRangeEnd, int grou
 	Int stepThread;
 	Int numthread;
 
-	stepThread.Set(&bc->ksFinish);
-	stepThread.Sub(&bc->ksStart);
+	stepThread.Set(&tRangeEnd);
+	stepThread.Sub(&tRangeStart);
 	stepThread.AddOne();
 	numthread.SetInt32(nbThread);
 	stepThread.Div(&numthread);
 
+	if (grp_startkeys < 2) {
+		// Few lanes (CPU engine), compute the starting keys directly
+		Int k;
+		for (int i = 0; i < nbThread; i++) {
+			k.Set(&stepThread);
+			k.Mult((uint64_t)i);
+			k.Add(&tRangeStart);
+			k.Add((uint64_t)(groupSize / 2 + Progress));
+			p[i] = secp->ComputePublicKey(&k);
+		}
+		return;
+	}
+
 	Point Pdouble;
 	Int kDouble;
 
@@ -855,47 +1304,89 @@ void VanitySearch::getGPUStartingKeys(Int& tRangeStart, Int& tRangeEnd, int grou
 
 void VanitySearch::FindKeyGPU(TH_PARAM* ph) {
 
-	
-	
+#ifdef WITHGPU
+
+	GPUEngine g(ph->gpuId, maxFound, this->batchSize);
+	int numThreadsGPU = g.GetNbThread();
+
+	fprintf(stdout, "GPU: %s\n", g.deviceName.c_str());
+	fflush(stdout);
+
+	// GPU threads take the head of the key space, CPU threads (if any) the tail
+	ph->nbLane = numThreadsGPU;
+	nbGPULane = numThreadsGPU;
+	ph->THrangeStart.Set(&bc->ksStart);
+	if (nbCPUThread > 0) {
+		Int cpuEnd;
+		getCPURange(0, ph->THrangeEnd, cpuEnd);
+		ph->THrangeEnd.SubOne();
+	} else {
+		ph->THrangeEnd.Set(&bc->ksFinish);
+	}
+
+	uint64_t nbLaunch = getResumeLaunch(ph, numThreadsGPU, g.GetStepSize(), 0);
+	FindKey(ph, &g, NULL, nbLaunch);
+
+#else
+	ph->hasStarted = true;
+	ph->isRunning = false;
+	printf("GPU code not compiled, use -DWITHGPU when compiling.\n");
+#endif
+
+}
+
+// Lookup tables (and xor filter of a CPU engine) of a target set
+void VanitySearch::setEngineTargets(ComputeEngine* g, CPUEngine* cpu, TARGET_SET* set) {
+
+	// With a target database and no GPU, CPU engines only get the 16 bits
+	// table and search the mapped database
+	if (set->onlyFull && set->usedAddressL.size() > 0) {
+		g->SetAddress(set->usedAddressL, set->nbAddress);
+	}
+	else {
+		g->SetAddress(set->usedAddress);
+	}
+	if (cpu) {
+		cpu->SetFilter(set->hasFilter ? &set->filter : NULL);
+		cpu->SetReportAll(set->patterns.GetSize() > 0);
+	}
+
+}
+
+void VanitySearch::FindKey(TH_PARAM* ph, ComputeEngine* g, CPUEngine* cpu, uint64_t& nbLaunch) {
 
 	bool ok = true;
 
 	double t0;
 	double ttot;
-	uint64_t keys_n = 0;
-	static uint64_t keys_n_prev = 0;
-	static double tprev = 0.0;
+	double tPause = 0;
 
 	// Global init
 	int thId = ph->threadId;
-	GPUEngine g(ph->gpuId, maxFound, this->batchSize);
-	int numThreadsGPU = g.GetNbThread();
-	int STEP_SIZE = g.GetStepSize();
-	Point* publicKeys = new Point[numThreadsGPU];
+	int numThreads = g->GetNbThread();
+	int STEP_SIZE = g->GetStepSize();
+	std::vector<Point> publicKeys(numThreads);
 	std::vector<ITEM> found;
+	std::vector<Int> patternKeys;
 
-	fprintf(stdout, "GPU: %s\n", g.deviceName.c_str());
-	fflush(stdout);
-
-	counters[thId] = 0;
+	counters[thId] = 1ULL * STEP_SIZE * numThreads * nbLaunch;
+	ph->nbLane = numThreads;
+	ph->stepSize = STEP_SIZE;
+	ph->nbLaunch = nbLaunch;
 	
-	g.SetSearchMode(searchMode);
-	g.SetSearchType(searchType);
-	if (onlyFull) {
-		g.SetAddress(usedAddressL, nbAddress);
-	}
-	else {
-		g.SetAddress(usedAddress);
-	}
+	g->SetSearchMode(searchMode);
+	g->SetSearchType(searchType);
+	std::shared_ptr<TARGET_SET> set = std::atomic_load(&targetSet);
+	setEngineTargets(g, cpu, set.get());
 
 	Int stepThread;
 	Int taskSize;
 	Int numthread;
 
-	taskSize.Set(&bc->ksFinish);
-	taskSize.Sub(&bc->ksStart);
+	taskSize.Set(&ph->THrangeEnd);
+	taskSize.Sub(&ph->THrangeStart);
 	taskSize.AddOne();
-	numthread.SetInt32(numThreadsGPU);
+	numthread.SetInt32(numThreads);
 	stepThread.Set(&taskSize);
 	stepThread.Div(&numthread);
 
@@ -905,109 +1396,114 @@ void VanitySearch::FindKeyGPU(TH_PARAM* ph) {
 
 	t0 = Timer::get_tick();
 
-	getGPUStartingKeys(bc->ksStart, bc->ksFinish, g.GetGroupSize(), numThreadsGPU, publicKeys, (uint64_t)(1ULL * idxcount * g.GetStepSize()));
-	ok = g.SetKeys(publicKeys);
-	delete[] publicKeys;
+	getGPUStartingKeys(ph->THrangeStart, ph->THrangeEnd, g->GetGroupSize(), numThreads, publicKeys.data(), (uint64_t)(1ULL * nbLaunch * STEP_SIZE));
+	ok = g->SetKeys(publicKeys.data());
+	publicKeys.clear();
 
-	ttot = Timer::get_tick() - t0;
-
-	printf("Starting keys set in %.2f seconds \n", ttot);
-	fflush(stdout);
+	if (thId & 0x80) {
+		ttot = Timer::get_tick() - t0;
+		printf("Starting keys set in %.2f seconds \n", ttot);
+		fflush(stdout);
+	}
 
 	ph->hasStarted = true;
 
-	printf("GPU Started ! \r");
-	fflush(stdout);
+	if (thId & 0x80) {
+		printf("GPU Started ! \r");
+		fflush(stdout);
+	}
 
 	t0 = Timer::get_tick();
 
-	endOfSearch = false;
+	// A resumed thread may already have completed its slice
+	keycount.SetInt32(0);
+	keycount.Add(nbLaunch);
+	keycount.Mult(STEP_SIZE);
+	bool sliceDone = keycount.IsGreaterOrEqual(&stepThread);
 
-	while (ok && !endOfSearch) {
+	while (ok && !sliceDone && !endOfSearch) {
 
 		if (!Pause) {
 
-			ok = g.Launch(found, true);
-			idxcount += 1;
+			// Targets reloaded, the engine keeps its keys
+			std::shared_ptr<TARGET_SET> newSet = std::atomic_load(&targetSet);
+			if (newSet != set) {
+				set = newSet;
+				setEngineTargets(g, cpu, set.get());
+			}
 
-			ttot = Timer::get_tick() - t0 + t_Paused;
+			ok = g->Launch(found, true);
+			nbLaunch += 1;
 
-			keycount.SetInt32(idxcount - 1);
+			keycount.SetInt32(0);
+			keycount.Add(nbLaunch - 1);
 			keycount.Mult(STEP_SIZE);
 
+			// With wildcard patterns a CPU engine reports every point
+			bool hasPattern = cpu && set->patterns.GetSize() > 0;
+			if (hasPattern)
+				patternKeys.resize(found.size());
+
 			for (int i = 0; i < (int)found.size() && !endOfSearch; i++) {
 
 				ITEM it = found[i];
 				part_key.Set(&stepThread);
 				part_key.Mult(it.thId);
 
-				privkey.Set(&bc->ksStart);
+				privkey.Set(&ph->THrangeStart);
 				privkey.Add(&part_key);
 				privkey.Add(&keycount);
 			
-				checkAddr(*(address_t*)(it.hash), it.hash, privkey, it.incr, it.endo, it.mode);
+				checkAddr(set.get(), *(address_t*)(it.hash), it.hash, privkey, it.incr, it.endo, it.mode);
+				if (hasPattern)
+					patternKeys[i].Set(&privkey);
 			}
 
-			keycount.Add(STEP_SIZE);
-			keycount.Mult(numThreadsGPU);
-
-			keys_n = 1ULL * STEP_SIZE * numThreadsGPU;
-			keys_n = keys_n * idxcount;
-
-		} else {
-			printf("Pausing...\r");
-			fflush(stdout);
-
-			g.FreeGPUEngine();
+			if (hasPattern)
+				checkAddrSSE(set.get(), found.data(), patternKeys.data(), (int)found.size());
 
-			Paused = true;
-			t_Paused = ttot;
-		}
-		
-		
-
-		PrintStats(keys_n, keys_n_prev, ttot, tprev, taskSize, keycount);
-
-		
+			keycount.Add(STEP_SIZE);
+			counters[thId] = 1ULL * STEP_SIZE * numThreads * nbLaunch;
+			ph->nbLaunch = nbLaunch;
 
-		if (keycount.IsGreaterOrEqual(&taskSize))
-		{
-			double avg_speed = static_cast<double>(keys_n) / (ttot * 1000000.0); // Avg speed in MK/s
-			printf("\n");
-			printf("Range Finished! - Average Speed: %.1f [MK/s] - Found: %d   \r", avg_speed, nbFoundKey);
-			printf("\n");
-			fflush(stdout);
+			ph->THnextKey.Set(&ph->THrangeStart);
+			ph->THnextKey.Add(&keycount);
 
-			char* ctimeBuff;
-			time_t now = time(NULL);
-			ctimeBuff = ctime(&now);
-			printf("Current task END time: %s", ctimeBuff);
+			sliceDone = keycount.IsGreaterOrEqual(&stepThread);
 
-			endOfSearch = true;
+		} else {
 
-			
+			// Quiesce in place: no new launch, the engine keeps its keys
+			// (and a GPU its last kernel results) until resume
+			double tp = Timer::get_tick();
+			while (Pause && !endOfSearch)
+				Timer::SleepMillis(10);
+			tPause += Timer::get_tick() - tp;
 
 		}
 
-		keys_n_prev = keys_n;
-		tprev = ttot ;
-
 	}
 
+	if (ok && !endOfSearch) {
+		double t = Timer::get_tick() - t0 - tPause;
+		printf("\n%s #%d: slice finished at %.3f MK/s\n", (thId & 0x80) ? "GPU" : "CPU Thread", thId & 0x7F,
+			(t > 0) ? (double)counters[thId] / t / 1000000.0 : 0.0);
+		fflush(stdout);
+	}
 
-	
+	// A failed engine ends the whole search
+	if (!ok)
+		endOfSearch = true;
 
 	ph->isRunning = false;
 
-	endOfSearch = true;
 }
 
-
 void VanitySearch::PrintStats(uint64_t keys_n, uint64_t keys_n_prev, double ttot, double tprev, Int taskSize, Int keycount) {
     // Calculate statistics
     double speed = (ttot > tprev) ? (keys_n - keys_n_prev) / (ttot - tprev) / 1000000.0 : 0;
     double perc = (keycount.IsZero() || taskSize.IsZero()) ? 0 :
-                 (100.0 * keycount.ToDouble() / taskSize.ToDouble());
+                 std::min(100.0, 100.0 * keycount.ToDouble() / taskSize.ToDouble());
     double log_keys = log2(static_cast<double>(keys_n));
 
     // Format time strings
@@ -1027,8 +1523,7 @@ void VanitySearch::PrintStats(uint64_t keys_n, uint64_t keys_n_prev, double ttot
     const int bar_width = 50;
     int pos = static_cast<int>(bar_width * perc / 100.0);
     std::string progress_bar = "[" + std::string(pos, '=') +
-                             (pos < bar_width ? ">" : "") +
-                             std::string(bar_width - pos - 1, ' ') + "]";
+                             (pos < bar_width ? ">" + std::string(bar_width - pos - 1, ' ') : "") + "]";
 
     // Print status line
     fmt::print("\r\033[K{} | {} | {:.1f} MK/s | 2^{:.2f} | {} {:.2f}% | Found: {} | ETA: {}",
@@ -1046,10 +1541,10 @@ void VanitySearch::PrintStats(uint64_t keys_n, uint64_t keys_n_prev, double ttot
 
 bool VanitySearch::isAlive(TH_PARAM * p) {
 
-	bool isAlive = true;
-	int total = numGPUs;
+	bool isAlive = false;
+	int total = nbCPUThread + numGPUs;
 	for (int i = 0; i < total; i++)
-		isAlive = isAlive && p[i].isRunning;
+		isAlive = isAlive || p[i].isRunning;
 
 	return isAlive;
 }
@@ -1057,7 +1552,7 @@ bool VanitySearch::isAlive(TH_PARAM * p) {
 bool VanitySearch::hasStarted(TH_PARAM * p) {
 
 	bool hasStarted = true;
-	int total = numGPUs;
+	int total = nbCPUThread + numGPUs;
 	for (int i = 0; i < total; i++)
 		hasStarted = hasStarted && p[i].hasStarted;
 
@@ -1068,41 +1563,364 @@ uint64_t VanitySearch::getGPUCount() {
 
 	uint64_t count = 0;
 	for (int i = 0; i < numGPUs; i++) {
+		count += counters[0x80 + i];
+	}
+	return count;
+}
+
+uint64_t VanitySearch::getCPUCount() {
+
+	uint64_t count = 0;
+	for (int i = 0; i < nbCPUThread; i++) {
 		count += counters[i];
 	}
 	return count;
 }
 
-void VanitySearch::saveProgress(TH_PARAM* p, Int& lastSaveKey, BITCRACK_PARAM* bc) {
+void VanitySearch::SetCheckpoint(std::string fileName, int interval, std::string digest, CHECKPOINT* resume) {
+
+	checkpointFile = fileName;
+	checkpointInterval = interval;
+	targetDigest = digest;
+	resumeState = resume;
+	if (resume)
+		nbFoundKey = resume->nbFound;
+
+}
+
+void VanitySearch::SetWorkClient(WorkClient* client) {
+
+	workClient = client;
+
+}
+
+void VanitySearch::SetEndomorphism(bool enable) {
+
+	useEndo = enable;
+
+}
+
+void VanitySearch::SetFilter(bool enable) {
+
+	// Also built for the reloaded sets
+	useFilter = enable;
+	if (!enable)
+		return;
+
+	if (!targetSet->onlyFull) {
+		fprintf(stdout, "Warning, xor filter needs full addresses, using lookup32\n");
+		return;
+	}
+
+	buildFilter(targetSet.get(), true);
+
+}
+
+// Xor filter of the full addresses of a set
+bool VanitySearch::buildFilter(TARGET_SET* set, bool verbose) {
+
+	set->hasFilter = false;
+	if (!set->onlyFull)
+		return false;
+
+	double t0 = Timer::get_tick();
+	std::vector<uint64_t> keys;
+	keys.reserve(set->nbAddress);
+	if (db) {
+		for (uint64_t i = 0; i < db->GetSize(); i++)
+			if (!dbFound[i])
+				keys.push_back(XorFilter::HashKey(db->GetRecord(i)));
+	}
+	else {
+		for (uint32_t i = 0; i < set->targets->GetNbFull(); i++)
+			if (!set->targets->IsFound(i))
+				keys.push_back(XorFilter::HashKey(set->targets->GetHash160(i)));
+	}
+
+	XorFilter& filter = set->filter;
+	if (!filter.Build(keys)) {
+		fprintf(stdout, "Warning, xor filter construction failed, using lookup32\n");
+		return false;
+	}
+	double t1 = Timer::get_tick();
+	set->hasFilter = true;
+	if (!verbose)
+		return true;
+
+	// Expected rate is 2^-32, measured on 2^24 random probes
+	uint64_t nbProbe = 1ULL << 24;
+	uint64_t nbHit;
+	filter.MeasureFP(nbProbe, &nbHit);
+
+	fprintf(stdout, "Xor filter: %zu keys, %.1f MB (%.1f bits/key), built in %.3f s, false positive %llu/%llu\n",
+		filter.GetSize(), (double)filter.GetMemory() / (1024.0 * 1024.0),
+		(double)filter.GetMemory() * 8.0 / (double)filter.GetSize(), t1 - t0,
+		(unsigned long long)nbHit, (unsigned long long)nbProbe);
+	return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+// Modification time of a file, 0 if it cannot be read
+static time_t fileTime(std::string& fileName) {
+
+	struct stat st;
+	if (stat(fileName.c_str(), &st) != 0)
+		return 0;
+	return st.st_mtime;
+
+}
+
+// Non empty lines of a target file, trailing spaces removed (as -i)
+static bool readTargetFile(std::string& fileName, std::vector<std::string>& lines) {
+
+	std::ifstream inFile(fileName);
+	if (!inFile.is_open())
+		return false;
+	std::string line;
+	while (std::getline(inFile, line)) {
+		while (line.length() > 0 && isspace((unsigned char)line.back()))
+			line.pop_back();
+		if (line.length() > 0)
+			lines.push_back(line);
+	}
+	return true;
+
+}
+
+void VanitySearch::SetInputFile(std::string fileName, bool watch) {
+
+	inputFile = fileName;
+	watchInput = watch;
+	inputTime = fileTime(inputFile);
+	inputTimeSeen = inputTime;
+
+}
+
+// Called by the search loop: start a reload on request, or when the
+// watched file has changed and then stayed the same for one more call
+// (still being written otherwise), swap the set in once built
+void VanitySearch::checkReload() {
+
+	if (reloadThread.joinable()) {
+		if (reloadDone)
+			swapReload();
+		return;
+	}
+
+	bool start = Reload && inputFile.length() > 0;
+	Reload = false;
+	if (watchInput) {
+		time_t t = fileTime(inputFile);
+		start |= (t != inputTime && t == inputTimeSeen);
+		inputTimeSeen = t;
+	}
+
+	reloadDone = false;
+	if (!start) {
+
+		// Found targets with -stop
+		if (!pruneRequest)
+			return;
+		pruneRequest = false;
+		reloadPrune = true;
+		std::shared_ptr<TARGET_SET> from = std::atomic_load(&targetSet);
+		reloadThread = std::thread([this, from]() {
+			double t0 = Timer::get_tick();
+			TARGET_SET* set = new TARGET_SET();
+			pruneTargets(from.get(), set);
+			reloadSet.reset(set);
+			reloadTime = Timer::get_tick() - t0;
+			reloadDone = true;
+		});
+		return;
+
+	}
+
+	inputTime = fileTime(inputFile);
+	inputTimeSeen = inputTime;
+	pruneRequest = false;
+	reloadPrune = false;
+	reloadThread = std::thread([this]() {
+		double t0 = Timer::get_tick();
+		TARGET_SET* set = newTargetSet();
+		std::vector<std::string> lines;
+		if (readTargetFile(inputFile, lines)) {
+			loadTargets(lines, set, false);
+			if (useFilter)
+				buildFilter(set, false);
+		}
+		reloadSet.reset(set);
+		reloadAddresses.swap(lines);
+		reloadTime = Timer::get_tick() - t0;
+		reloadDone = true;
+	});
+
+}
+
+void VanitySearch::swapReload() {
+
+	reloadThread.join();
+
+	if (reloadPrune) {
+		std::atomic_store(&targetSet, reloadSet);
+		printf("\n[stop] %u targets left, lookup rebuilt in %.3f s\n", reloadSet->nbAddress, reloadTime);
+	}
+	else if (reloadSet->nbAddress == 0) {
+		printf("\n[reload] %s: nothing to search, targets kept\n", inputFile.c_str());
+	}
+	else {
+		// Workers switch to the new set before their next launch
+		std::atomic_store(&targetSet, reloadSet);
+		inputAddresses.swap(reloadAddresses);
+		if (checkpointFile.length() > 0)
+			targetDigest = Checkpoint::TargetDigest(inputAddresses);
+		printf("\n[reload] %s: %u targets%s, built in %.3f s\n", inputFile.c_str(), reloadSet->nbAddress,
+			reloadSet->hasFilter ? " (xor filter)" : "", reloadTime);
+	}
+	fflush(stdout);
+
+	reloadSet.reset();
+	std::vector<std::string>().swap(reloadAddresses);
+
+}
+
+// Tables of the targets of from not found yet, sharing its store. The
+// found flags are atomic and read without mutex, a target found during
+// the rebuild is dropped by the next one.
+void VanitySearch::pruneTargets(TARGET_SET* from, TARGET_SET* set) {
+
+	set->targets = from->targets;
+	set->patterns = from->patterns;
+	set->onlyFull = from->onlyFull;
+	set->hasFilter = false;
+
+	if (db) {
+		buildDBLookup(set, from->usedAddressL.size() > 0);
+	}
+	else {
+		TargetStore* targets = set->targets.get();
+		uint32_t nbFull = targets->GetLookup(set->usedAddress, set->usedAddressL, true);
+		set->nbAddress = set->onlyFull ? nbFull : targets->GetNbTarget() - targets->GetNbFound();
+	}
+	if (from->hasFilter)
+		buildFilter(set, false);
+
+}
+
+// 16 bits table of the database buckets with a target not found yet, and
+// the 32 bits lookup if secondLevel (GPU)
+void VanitySearch::buildDBLookup(TARGET_SET* set, bool secondLevel) {
+
+	set->usedAddress.clear();
+	set->usedAddressL.clear();
+	set->nbAddress = 0;
+
+	// Records are sorted by bytes, the 32 bits lookup by little endian value
+	for (int i = 0; i < 65536; i++) {
+		LADDRESS lit;
+		uint64_t begin, end;
+		lit.sAddress = (address_t)i;
+		db->GetBucket((address_t)i, begin, end);
+		uint32_t nb = 0;
+		for (uint64_t j = begin; j < end; j++) {
+			if (dbFound[j])
+				continue;
+			if (secondLevel)
+				lit.lAddresses.push_back(*(addressl_t*)db->GetRecord(j));
+			nb++;
+		}
+		if (nb == 0)
+			continue;
+		set->usedAddress.push_back((address_t)i);
+		set->nbAddress += nb;
+		if (secondLevel) {
+			std::sort(lit.lAddresses.begin(), lit.lAddresses.end());
+			set->usedAddressL.push_back(lit);
+		}
+	}
+
+}
+
+uint64_t VanitySearch::getResumeLaunch(TH_PARAM* p, int nbLane, int stepSize, uint64_t defaultLaunch) {
+
+	if (resumeState == NULL)
+		return defaultLaunch;
+
+	for (int i = 0; i < (int)resumeState->workers.size(); i++) {
+		CHECKPOINT_WORKER* w = &resumeState->workers[i];
+		if (w->threadId != p->threadId)
+			continue;
+		if (w->nbLane == nbLane && w->stepSize == stepSize &&
+			w->rangeStart.IsEqual(&p->THrangeStart) && w->rangeEnd.IsEqual(&p->THrangeEnd))
+			return w->nbLaunch;
+		// Another layout (thread or GPU lane count changed), redo this slice
+		printf("\n[checkpoint] Thread #%d layout changed, restarting its slice\n", p->threadId);
+		return 0;
+	}
+
+	if (resumeState->workers.size() > 0)
+		printf("\n[checkpoint] Thread #%d not in checkpoint, restarting its slice\n", p->threadId);
+	return 0;
+
+}
+
+void VanitySearch::saveProgress(TH_PARAM* p, double elapsed) {
 
-	Int lowerKey;
-	lowerKey.Set(&p[0].THnextKey);
+	// Snapshot of the completed launches, taken from the search loop so the
+	// working threads never wait on the disk
+	CHECKPOINT cp;
+	cp.ksStart.Set(&bc->ksStart);
+	cp.ksFinish.Set(&bc->ksFinish);
+	cp.targetDigest = targetDigest;
+	cp.nbTarget = db ? (uint32_t)db->GetSize() : (uint32_t)inputAddresses.size();
+	cp.nbFound = nbFoundKey;
+	cp.elapsed = elapsed;
 
-	int total = numGPUs;
+	int total = nbCPUThread + numGPUs;
 	for (int i = 0; i < total; i++) {
-		if (p[i].THnextKey.IsLower(&lowerKey))
-			lowerKey.Set(&p[i].THnextKey);
+		if (!p[i].hasStarted || p[i].nbLane == 0)
+			continue;
+		CHECKPOINT_WORKER w;
+		w.threadId = p[i].threadId;
+		w.nbLane = p[i].nbLane;
+		w.stepSize = p[i].stepSize;
+		w.nbLaunch = p[i].nbLaunch;
+		w.rangeStart.Set(&p[i].THrangeStart);
+		w.rangeEnd.Set(&p[i].THrangeEnd);
+		cp.workers.push_back(w);
 	}
 
-	if (lowerKey.IsLowerOrEqual(&lastSaveKey)) return;
-	lastSaveKey.Set(&lowerKey);
+	Checkpoint::Save(checkpointFile, cp);
+
 }
 
-void VanitySearch::Search(std::vector<int> gpuId, std::vector<int> gridSize) {
+bool VanitySearch::Search(int nbThread, std::vector<int> gpuId, std::vector<int> gridSize) {
 
 	double t0;
 	double t1;
+	double ttot = t_Paused;
 	endOfSearch = false;
-	/*numGPUs = ((int)gpuId.size());*/
-	numGPUs = 1;
-	nbFoundKey = 0;
+	// One GPU per process, CPU threads use thread ids 0..0x7F
+	nbCPUThread = std::max(0, std::min(nbThread, 0x80));
+	numGPUs = (gpuId.size() > 0) ? 1 : 0;
+	nbGPULane = 0;
 
 	memset(counters, 0, sizeof(counters));	
 
-	TH_PARAM* params = (TH_PARAM*)malloc(numGPUs * sizeof(TH_PARAM));
-	memset(params, 0, numGPUs * sizeof(TH_PARAM));
+	// The GPU kernel needs the 32 bits lookup in device memory
+	if (db && numGPUs > 0 && targetSet->usedAddressL.size() == 0)
+		buildDBLookup(targetSet.get(), true);
+
+	if (numGPUs > 0 && targetSet->patterns.GetSize() > 0)
+		printf("Wildcard patterns are only searched by the CPU threads\n");
+
+	int total = nbCPUThread + numGPUs;
+	TH_PARAM* params = (TH_PARAM*)malloc(total * sizeof(TH_PARAM));
+	memset(params, 0, total * sizeof(TH_PARAM));
 	
-	std::thread* threads = new std::thread[numGPUs];
+	std::vector<std::thread> threads(total);
 
 #ifdef WIN64
 	ghMutex = CreateMutex(NULL, FALSE, NULL);
@@ -1112,33 +1930,137 @@ void VanitySearch::Search(std::vector<int> gpuId, std::vector<int> gridSize) {
 	mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
-	// Launch GPU threads
+	double tLaunch = Timer::get_tick();
+
+	// Launch GPU threads, the CPU slices are laid out after the GPU ones
+	// so we wait for the GPU thread count before starting the CPU threads
 	for (int i = 0; i < numGPUs; i++) {
+		TH_PARAM* p = params + nbCPUThread + i;
+		p->obj = this;
+		p->threadId = 0x80 + i;
+		p->isRunning = true;
+		p->gpuId = gpuId[i];
+		p->gridSizeX = gridSize[2 * i];
+		p->gridSizeY = gridSize[2 * i + 1];
+		p->THnextKey.Set(&bc->ksNext);
+		
+		threads[nbCPUThread + i] = std::thread(_FindKeyGPU, p);
+	}
+
+	while (numGPUs > 0 && !params[nbCPUThread].hasStarted) {
+		Timer::SleepMillis(100);
+	}
+
+	// Launch CPU threads
+	for (int i = 0; i < nbCPUThread && !endOfSearch; i++) {
 		params[i].obj = this;
 		params[i].threadId = i;
 		params[i].isRunning = true;
-		params[i].gpuId = gpuId[i];
-		params[i].gridSizeX = gridSize[i];
-		params[i].gridSizeY = gridSize[i+1];
-		params[i].THnextKey.Set(&bc->ksNext);
-		
-		threads[i] = std::thread(_FindKeyGPU, params + i);
+		params[i].nbLane = 1;
+		getCPURange(i, params[i].THrangeStart, params[i].THrangeEnd);
+		params[i].THnextKey.Set(&params[i].THrangeStart);
+
+		threads[i] = std::thread(_FindKeyCPU, params + i);
 	}
 
-	while (!hasStarted(params)) {
-		Timer::SleepMillis(500);
+	if (nbCPUThread > 0) {
+		printf("CPU threads: %d%s\n", nbCPUThread, useEndo ? " (endomorphism, 6 keys per point)" : "");
+		fflush(stdout);
 	}
 
-	while (!endOfSearch) {
+	while (!hasStarted(params) && isAlive(params)) {
 		Timer::SleepMillis(100);
 	}
 
-	
+	Int taskSize;
+	taskSize.Set(&bc->ksFinish);
+	taskSize.Sub(&bc->ksStart);
+	taskSize.AddOne();
+
+	Int keycount;
+	uint64_t keys_n = getGPUCount() + getCPUCount();
+	uint64_t keys_n_prev = keys_n;
+	double tprev = t_Paused;
+
+	t0 = Timer::get_tick();
+	t1 = t0;
+	double tCheckpoint = t0;
+
+	while (isAlive(params)) {
+
+		Timer::SleepMillis(STATS_INTERVAL);
+
+		double t = Timer::get_tick();
+
+		// Hold the clock while paused
+		Paused = (bool)Pause;
+		if (Paused)
+			t0 += t - t1;
+		t1 = t;
+		ttot = t1 - t0 + t_Paused;
+
+		keys_n = getGPUCount() + getCPUCount();
+		keycount.SetInt32(0);
+		keycount.Add(keys_n);
+
+		PrintStats(keys_n, keys_n_prev, ttot, tprev, taskSize, keycount);
+
+		keys_n_prev = keys_n;
+		tprev = ttot;
+
+		if (checkpointFile.length() > 0 && t1 - tCheckpoint >= checkpointInterval) {
+			saveProgress(params, ttot);
+			tCheckpoint = t1;
+		}
+
+		checkReload();
+
+	}
+
+	for (int i = 0; i < total; i++) {
+		if (threads[i].joinable())
+			threads[i].join();
+	}
+
+	// A reload still being built is kept for the next range
+	if (reloadThread.joinable())
+		swapReload();
+
+	// Short ranges may end before the first stats update, or even before
+	// all threads have started
+	keys_n = getGPUCount() + getCPUCount();
+	if (!Paused)
+		ttot = Timer::get_tick() - ((t1 == t0) ? tLaunch : t0) + t_Paused;
+
+	if (checkpointFile.length() > 0)
+		saveProgress(params, ttot);
+
+	// Below one display interval the elapsed time is mostly the thread startup,
+	// the speed would be meaningless
+	const char* status = allFound ? "All targets found!" : "Range Finished!";
+	printf("\n");
+	if (ttot * 1000.0 >= STATS_INTERVAL) {
+		double avg_speed = static_cast<double>(keys_n) / (ttot * 1000000.0); // Avg speed in MK/s
+		printf("%s - Average Speed: %.1f [MK/s] - Found: %d   \r", status, avg_speed, nbFoundKey);
+	} else {
+		printf("%s - Found: %d   \r", status, nbFoundKey);
+	}
+	printf("\n");
+	fflush(stdout);
+
+	char* ctimeBuff;
+	time_t now = time(NULL);
+	ctimeBuff = ctime(&now);
+	printf("Current task END time: %s", ctimeBuff);
 
 	if (params != nullptr) {
 		free(params);
 	}
 
+	// False when an engine failed, or when all the targets were found (-stop),
+	// before the end of the range
+	return !endOfSearch;
+
 }
 
 std::string VanitySearch::GetHex(std::vector<unsigned char> &buffer) {
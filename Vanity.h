@@ -21,18 +21,33 @@
 #include <string>
 #include <vector>
 #include "SECP256k1.h"
+#include "CPUEngine.h"
+#include "TargetDB.h"
+#include "TargetStore.h"
+#include "PatternMatcher.h"
+#include "Checkpoint.h"
 #include "GPU/GPUEngine.h"
 #include <atomic>
+#include <memory>
+#include <thread>
 #ifdef WIN64
 #include <Windows.h>
 #endif
 
 extern std::atomic<bool> Pause;
 extern std::atomic<bool> Paused;
-extern int idxcount;
+extern std::atomic<bool> Reload;
 extern double t_Paused;
 
 class VanitySearch;
+class WorkClient;
+
+// Key space weight of a CPU thread against a single GPU thread when both
+// engines share the same range (a CPU core runs ~16x faster than one GPU thread)
+#define CPU_LANE_WEIGHT 16
+
+// Stats display interval (ms)
+#define STATS_INTERVAL 500
 
 #ifdef WIN64
 //typedef HANDLE THREAD_HANDLE;
@@ -53,7 +68,12 @@ typedef struct {
 	int  gridSizeX;
 	int  gridSizeY;
 	int  gpuId;
+	int  nbLane;
+	int  stepSize;
+	uint64_t nbLaunch;
 	Int  THnextKey;
+	Int  THrangeStart;
+	Int  THrangeEnd;
 
 } TH_PARAM;
 
@@ -62,21 +82,38 @@ typedef struct {
 	std::string address;
 	int addressLength;
 	address_t sAddress;	
-	bool* found;
 
 	// For dreamer ;)
 	bool isFull;
+	bool isPattern;
 	addressl_t lAddress;
 	uint8_t hash160[20];
 
+	// Hash160 intervals of a prefix, partial when they only cover the
+	// first characters (the address string decides)
+	int nbRange;
+	uint8_t rangeLo[PREFIX_MAX_RANGE][20];
+	uint8_t rangeHi[PREFIX_MAX_RANGE][20];
+	bool rangePartial;
+
 } ADDRESS_ITEM;
 
+// Targets and the engine lookup tables built from them. A reload builds a
+// new set in the background, the workers switch to it between launches.
+// With -stop the found targets are dropped from the tables of a new set
+// sharing the same store (and found flags).
 typedef struct {
 
-	std::vector<ADDRESS_ITEM>* items;
-	bool found;
+	std::shared_ptr<TargetStore> targets;
+	PatternMatcher patterns;
+	XorFilter filter;
+	bool hasFilter;
+	std::vector<address_t> usedAddress;
+	std::vector<LADDRESS> usedAddressL;
+	uint32_t nbAddress;
+	bool onlyFull;
 
-} ADDRESS_TABLE_ITEM;
+} TARGET_SET;
 
 typedef struct {
 
@@ -91,20 +128,28 @@ class VanitySearch {
 public:
 
 	VanitySearch(Secp256K1* secp, std::vector<std::string>& address, int searchMode,
-	    bool stop, std::string outputFile, uint32_t maxFound, BITCRACK_PARAM* bc, int batchSize);
+	    bool stop, std::string outputFile, uint32_t maxFound, BITCRACK_PARAM* bc, int batchSize, TargetDB* db = NULL,
+	    bool caseSensitive = true);
 
-	void Search(std::vector<int> gpuId, std::vector<int> gridSize);
+	bool Search(int nbThread, std::vector<int> gpuId, std::vector<int> gridSize);
+	void FindKeyCPU(TH_PARAM* p);
 	void FindKeyGPU(TH_PARAM* p);
+	void FindKey(TH_PARAM* p, ComputeEngine* g, CPUEngine* cpu, uint64_t& nbLaunch);
+	void SetCheckpoint(std::string fileName, int interval, std::string digest, CHECKPOINT* resume);
+	void SetWorkClient(WorkClient* client);
+	void SetEndomorphism(bool enable);
+	void SetFilter(bool enable);
+
+	// Input file reloaded on Reload (key 'r'), or on each change if watch
+	void SetInputFile(std::string fileName, bool watch);
 
 private:
 
 	std::string GetHex(std::vector<unsigned char>& buffer);
 	std::string GetExpectedTimeBitCrack(double keyRate, double keyCount, BITCRACK_PARAM* bc);
 	bool checkPrivKey(std::string addr, Int& key, int32_t incr, int endomorphism, bool mode);
-	void checkAddr(int prefIdx, uint8_t* hash160, Int& key, int32_t incr, int endomorphism, bool mode);
-	void checkAddrSSE(uint8_t* h1, uint8_t* h2, uint8_t* h3, uint8_t* h4,
-		int32_t incr1, int32_t incr2, int32_t incr3, int32_t incr4,
-		Int& key, int endomorphism, bool mode);
+	void checkAddr(TARGET_SET* set, int prefIdx, uint8_t* hash160, Int& key, int32_t incr, int endomorphism, bool mode);
+	void checkAddrSSE(TARGET_SET* set, ITEM* items, Int* keys, int n);
 	void checkAddresses(bool compressed, Int key, int i, Point p1);
 	void checkAddressesSSE(bool compressed, Int key, int i, Point p1, Point p2, Point p3, Point p4);
 	void output(const std::vector<std::tuple<std::string, std::string, std::string, std::string>>& foundKeys);
@@ -121,10 +166,22 @@ private:
 	bool isSingularAddress(std::string pref);
 	bool hasStarted(TH_PARAM* p);
 	uint64_t getGPUCount();
+	uint64_t getCPUCount();
+	void getCPURange(int thId, Int& rangeStart, Int& rangeEnd);
 	bool initAddress(std::string& address, ADDRESS_ITEM* it);
 	void updateFound();
+	void buildDBLookup(TARGET_SET* set, bool secondLevel);
 	void getGPUStartingKeys(Int& tRangeStart, Int& tRangeEnd, int groupSize, int numThreadsGPU, Point* publicKeys, uint64_t Progress);
-	void enumCaseUnsentiveAddress(std::string s, std::vector<std::string>& list);
+	int enumCaseUnsentiveAddress(std::string s, std::vector<std::string>& list);
+	bool initCaseInsensitive(std::string& prefix, uint32_t group, TARGET_SET* set);
+	bool addTarget(std::string& address, uint32_t& nbGroup, TARGET_SET* set);
+	void loadTargets(std::vector<std::string>& inputs, TARGET_SET* set, bool verbose);
+	bool buildFilter(TARGET_SET* set, bool verbose);
+	void setEngineTargets(ComputeEngine* g, CPUEngine* cpu, TARGET_SET* set);
+	void checkReload();
+	void swapReload();
+	void pruneTargets(TARGET_SET* from, TARGET_SET* set);
+	void targetFound(TARGET_SET* set);
 	void PrintStats(uint64_t keys_n, uint64_t keys_n_prev, double ttot, double tprev, Int taskSize, Int keycount);
 
 	Secp256K1* secp;
@@ -136,20 +193,46 @@ private:
 	bool stopWhenFound;
 	bool endOfSearch;
 	int numGPUs;
+	int nbCPUThread;
+	int nbGPULane;
 	int nbFoundKey;
-	uint32_t nbAddress;
 	std::string outputFile;
 	bool useSSE;
-	bool onlyFull;
+	bool useEndo;
+	bool caseSensitive;
+	bool useFilter;
+	TargetDB* db;
+	std::vector<std::atomic<uint8_t>> dbFound;
+	uint64_t nbDBFound;
 	uint32_t maxFound;	
-	std::vector<ADDRESS_TABLE_ITEM> addresses;
-	std::vector<address_t> usedAddress;
-	std::vector<LADDRESS> usedAddressL;
+	std::shared_ptr<TARGET_SET> targetSet;
 	std::vector<std::string>& inputAddresses;
 
+	// Target reload, the new set is built by reloadThread and swapped in
+	// by the search loop
+	std::string inputFile;
+	bool watchInput;
+	time_t inputTime;
+	time_t inputTimeSeen;
+	std::thread reloadThread;
+	std::atomic<bool> reloadDone;
+	double reloadTime;
+	bool reloadPrune;
+	std::atomic<bool> pruneRequest;
+	bool allFound;
+	std::shared_ptr<TARGET_SET> reloadSet;
+	std::vector<std::string> reloadAddresses;
+
 	BITCRACK_PARAM* bc;
 	int batchSize;
-	void saveProgress(TH_PARAM* p, Int& lastSaveKey, BITCRACK_PARAM* bc);
+	void saveProgress(TH_PARAM* p, double elapsed);
+	uint64_t getResumeLaunch(TH_PARAM* p, int nbLane, int stepSize, uint64_t defaultLaunch);
+
+	std::string checkpointFile;
+	int checkpointInterval;
+	std::string targetDigest;
+	CHECKPOINT* resumeState;
+	WorkClient* workClient;
 
 	Int firstGPUThreadLastPrivateKey;
 
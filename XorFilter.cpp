@@ -0,0 +1,191 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "XorFilter.h"
+#include "Random.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#define XOR_MAX_ATTEMPT 64
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+
+XorFilter::XorFilter() {
+
+  seed = 0;
+  blockLength = 0;
+  size = 0;
+
+}
+
+size_t XorFilter::GetSize() {
+  return size;
+}
+
+size_t XorFilter::GetMemory() {
+  return fingerprints.size() * sizeof(uint32_t);
+}
+
+// ----------------------------------------------------------------------------
+
+bool XorFilter::Build(vector<uint64_t> &keys) {
+
+  // Duplicates can't be peeled
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  size = keys.size();
+
+  uint64_t capacity = 32 + (uint64_t)ceil(1.23 * (double)size);
+  capacity = capacity / 3 * 3;
+  if (capacity > 0xFFFFFFFFULL) {
+    fprintf(stderr, "[ERROR] XorFilter: too many keys (%zu)\n", size);
+    return false;
+  }
+  blockLength = (uint32_t)(capacity / 3);
+
+  vector<uint64_t> xorMask(capacity);
+  vector<uint32_t> count(capacity);
+  vector<uint32_t> queue;
+  vector<uint64_t> stackHash(size);
+  vector<uint32_t> stackIdx(size);
+  queue.reserve(capacity);
+
+  size_t nbPeeled = 0;
+  int attempt = 0;
+
+  while (nbPeeled != size && attempt < XOR_MAX_ATTEMPT) {
+
+    seed = ((uint64_t)rndl() << 32) | (uint64_t)rndl();
+    attempt++;
+
+    std::fill(xorMask.begin(), xorMask.end(), 0);
+    std::fill(count.begin(), count.end(), 0);
+
+    for (size_t i = 0; i < size; i++) {
+      uint64_t h = Mix(keys[i], seed);
+      uint32_t i0 = H0(h);
+      uint32_t i1 = H1(h);
+      uint32_t i2 = H2(h);
+      xorMask[i0] ^= h; count[i0]++;
+      xorMask[i1] ^= h; count[i1]++;
+      xorMask[i2] ^= h; count[i2]++;
+    }
+
+    // Peel the slots used by a single key
+    queue.clear();
+    for (uint32_t i = 0; i < (uint32_t)capacity; i++)
+      if (count[i] == 1)
+        queue.push_back(i);
+
+    nbPeeled = 0;
+    while (!queue.empty()) {
+      uint32_t idx = queue.back();
+      queue.pop_back();
+      if (count[idx] != 1)
+        continue;
+      uint64_t h = xorMask[idx];
+      stackHash[nbPeeled] = h;
+      stackIdx[nbPeeled] = idx;
+      nbPeeled++;
+      uint32_t slots[3] = { H0(h), H1(h), H2(h) };
+      for (int j = 0; j < 3; j++) {
+        xorMask[slots[j]] ^= h;
+        count[slots[j]]--;
+        if (count[slots[j]] == 1)
+          queue.push_back(slots[j]);
+      }
+    }
+
+  }
+
+  if (nbPeeled != size) {
+    fprintf(stderr, "[ERROR] XorFilter: construction failed after %d attempts\n", attempt);
+    fingerprints.clear();
+    return false;
+  }
+
+  // Assign in reverse peeling order, the slot of each key is still 0
+  fingerprints.assign(capacity, 0);
+  for (size_t i = size; i-- > 0;) {
+    uint64_t h = stackHash[i];
+    fingerprints[stackIdx[i]] = Fingerprint(h) ^ fingerprints[H0(h)] ^ fingerprints[H1(h)] ^ fingerprints[H2(h)];
+  }
+
+  return true;
+
+}
+
+// ----------------------------------------------------------------------------
+
+double XorFilter::MeasureFP(uint64_t nbProbe, uint64_t *nbHit) {
+
+  // splitmix64 sequence, a random key is a member with probability size/2^64
+  uint64_t x = ((uint64_t)rndl() << 32) | (uint64_t)rndl();
+  uint64_t hit = 0;
+  for (uint64_t i = 0; i < nbProbe; i++) {
+    x += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = x;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    if (Contain(z))
+      hit++;
+  }
+  if (nbHit) *nbHit = hit;
+  return (nbProbe > 0) ? (double)hit / (double)nbProbe : 0.0;
+
+}
+
+bool XorFilter::Check() {
+
+  const size_t nbKey = 1000000;
+  const uint64_t nbProbe = 1ULL << 24;
+
+  printf("XorFilter: Check %zu keys: ", nbKey);
+
+  vector<uint64_t> keys(nbKey);
+  for (size_t i = 0; i < nbKey; i++)
+    keys[i] = ((uint64_t)rndl() << 32) | (uint64_t)rndl();
+  vector<uint64_t> members(keys);
+
+  if (!Build(keys)) {
+    printf("Failed ! (construction)\n");
+    return false;
+  }
+
+  size_t nbMissing = 0;
+  for (size_t i = 0; i < nbKey; i++)
+    if (!Contain(members[i]))
+      nbMissing++;
+
+  // 2^-32 expected, 2^24 probes should give no hit
+  uint64_t nbHit;
+  MeasureFP(nbProbe, &nbHit);
+
+  bool ok = (nbMissing == 0) && (nbHit < 4);
+  if (ok) {
+    printf("OK (%.1f bits/key, false positive %llu/%llu)\n", (double)GetMemory() * 8.0 / (double)GetSize(),
+      (unsigned long long)nbHit, (unsigned long long)nbProbe);
+  } else {
+    printf("Failed ! (%zu missing, false positive %llu/%llu)\n", nbMissing, (unsigned long long)nbHit, (unsigned long long)nbProbe);
+  }
+  return ok;
+
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XORFILTERH
+#define XORFILTERH
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <xmmintrin.h>
+
+// Static xor filter with 32 bits fingerprints (Graf & Lemire): 3 memory
+// accesses per probe, ~39 bits per key, false positive rate 2^-32
+class XorFilter {
+
+public:
+
+  XorFilter();
+
+  // Build from the hash160 of the targets, duplicates are allowed
+  bool Build(std::vector<uint64_t> &keys);
+  size_t GetSize();
+  size_t GetMemory();
+
+  // Fraction of nbProbe random keys reported as members
+  double MeasureFP(uint64_t nbProbe, uint64_t *nbHit);
+  bool Check();
+
+  static inline uint64_t HashKey(const uint8_t *h160) {
+    uint64_t a, b;
+    uint32_t c;
+    memcpy(&a, h160, 8);
+    memcpy(&b, h160 + 8, 8);
+    memcpy(&c, h160 + 16, 4);
+    return a ^ ((b << 21) | (b >> 43)) ^ ((uint64_t)c << 32) ^ c;
+  }
+
+  inline bool Contain(uint64_t key) {
+    uint64_t h = Mix(key, seed);
+    uint32_t f = Fingerprint(h);
+    return f == (fingerprints[H0(h)] ^ fingerprints[H1(h)] ^ fingerprints[H2(h)]);
+  }
+
+  inline void Prefetch(uint64_t key) {
+    uint64_t h = Mix(key, seed);
+    _mm_prefetch((const char *)&fingerprints[H0(h)], _MM_HINT_T0);
+    _mm_prefetch((const char *)&fingerprints[H1(h)], _MM_HINT_T0);
+    _mm_prefetch((const char *)&fingerprints[H2(h)], _MM_HINT_T0);
+  }
+
+private:
+
+  static inline uint64_t Mix(uint64_t key, uint64_t seed) {
+    uint64_t h = key + seed;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static inline uint32_t Fingerprint(uint64_t h) {
+    return (uint32_t)(h ^ (h >> 32));
+  }
+
+  static inline uint32_t Reduce(uint32_t h, uint32_t n) {
+    return (uint32_t)(((uint64_t)h * n) >> 32);
+  }
+
+  inline uint32_t H0(uint64_t h) { return Reduce((uint32_t)h, blockLength); }
+  inline uint32_t H1(uint64_t h) { return Reduce((uint32_t)((h << 21) | (h >> 43)), blockLength) + blockLength; }
+  inline uint32_t H2(uint64_t h) { return Reduce((uint32_t)((h << 42) | (h >> 22)), blockLength) + 2 * blockLength; }
+
+  uint64_t seed;
+  uint32_t blockLength;
+  size_t size;
+  std::vector<uint32_t> fingerprints;
+
+};
+
+#endif // XORFILTERH
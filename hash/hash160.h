@@ -0,0 +1,33 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HASH160_H
+#define HASH160_H
+
+#include <stdint.h>
+
+// Fused RIPEMD-160(SHA-256()) of N compressed public keys (P2PKH hash160).
+// The keys are given in SoA form: x[j * N + l] is the 32 bits word j (most
+// significant first) of the x coordinate of lane l, odd[l] is 1 when its y
+// is odd, else 0. Lane l hash160 is written to hash[l].
+void hash160sse_comp(const uint32_t *x, const uint32_t *odd, uint8_t *hash[4]);
+// AVX2 CPU only
+void hash160avx2_comp(const uint32_t *x, const uint32_t *odd, uint8_t *hash[8]);
+// AVX-512F CPU only
+void hash160avx512_comp(const uint32_t *x, const uint32_t *odd, uint8_t *hash[16]);
+
+#endif // HASH160_H
@@ -0,0 +1,457 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hash160.h"
+#include <immintrin.h>
+
+// 4 lanes SSE hash160 of compressed public keys. The 33 bytes key and
+// its padding are built from the x words in the registers: only w0-w8
+// of the SHA-256 block vary, w9-w15 (zeros and the bit length) are
+// folded in the rounds and in the message schedule. The SHA-256 digest
+// is the RIPEMD-160 message without going through memory, its padding
+// words are folded the same way.
+#define ADD(x,y)  _mm_add_epi32(x, y)
+#define SET1(x)   _mm_set1_epi32((int)(x))
+#define OR(x,y)   _mm_or_si128(x, y)
+#define SHL(x,n)  _mm_slli_epi32(x, n)
+#define SHR(x,n)  _mm_srli_epi32(x, n)
+#define LOADU(p)   _mm_loadu_si128((const __m128i *)(p))
+#define STOREU(p,x) _mm_storeu_si128((__m128i *)(p), x)
+#define BSWAP(x)  _mm_shuffle_epi8(x, bswap)
+#define NOT(x)    _mm_xor_si128(x, _mm_set1_epi32(-1))
+
+#define Maj(b,c,d) _mm_or_si128(_mm_and_si128(b, c), _mm_and_si128(d, _mm_or_si128(b, c)))
+#define Ch(b,c,d)  _mm_xor_si128(_mm_and_si128(b, c), _mm_andnot_si128(b, d))
+#define ROR(x,n)   _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n))
+#define ROL(x,n)   _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n))
+#define XOR3(x,y,z) _mm_xor_si128(x, _mm_xor_si128(y, z))
+
+#define f1(x,y,z) _mm_xor_si128(x, _mm_xor_si128(y, z))
+#define f2(x,y,z) _mm_or_si128(_mm_and_si128(x, y), _mm_andnot_si128(x, z))
+#define f3(x,y,z) _mm_xor_si128(_mm_or_si128(x, NOT(y)), z)
+#define f4(x,y,z) _mm_or_si128(_mm_and_si128(x, z), _mm_andnot_si128(z, y))
+#define f5(x,y,z) _mm_xor_si128(x, _mm_or_si128(y, NOT(z)))
+
+  /* SHA256 Functions */
+#define S0(x) XOR3(ROR((x), 2), ROR((x), 13), ROR((x), 22))
+#define S1(x) XOR3(ROR((x), 6), ROR((x), 11), ROR((x), 25))
+#define s0(x) XOR3(ROR((x), 7), ROR((x), 18), SHR((x), 3))
+#define s1(x) XOR3(ROR((x), 17), ROR((x), 19), SHR((x), 10))
+
+#define add3(x0, x1, x2) ADD(ADD(x0, x1), x2)
+#define add4(x0, x1, x2, x3) ADD(ADD(x0, x1), ADD(x2, x3))
+
+// SHA-256 round, RoundC has a constant message word (k + w)
+#define Round(a, b, c, d, e, f, g, h, k, w) \
+  T1 = add4(h, S1(e), Ch(e, f, g), ADD(SET1(k), w)); \
+  d = ADD(d, T1); \
+  h = add3(T1, S0(a), Maj(a, b, c));
+
+#define RoundC(a, b, c, d, e, f, g, h, kw) \
+  T1 = add4(h, S1(e), Ch(e, f, g), SET1(kw)); \
+  d = ADD(d, T1); \
+  h = add3(T1, S0(a), Maj(a, b, c));
+
+// RIPEMD-160 round, RRoundC has a constant message word
+#define RRound(a,b,c,d,e,f,x,k,r) \
+  u = add4(a, f, x, SET1(k)); \
+  a = ADD(ROL(u, r), e); \
+  c = ROL(c, 10);
+
+#define RRoundC(a,b,c,d,e,f,x,k,r) \
+  u = add3(a, f, SET1((x) + (k))); \
+  a = ADD(ROL(u, r), e); \
+  c = ROL(c, 10);
+
+#define R11(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R21(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r)
+#define R31(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r)
+#define R41(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r)
+#define R51(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r)
+#define R12(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r)
+#define R22(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r)
+#define R32(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r)
+#define R42(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r)
+#define R52(a,b,c,d,e,x,r) RRound(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R11C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f1(b, c, d), x, 0, r)
+#define R21C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f2(b, c, d), x, 0x5A827999ul, r)
+#define R31C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f3(b, c, d), x, 0x6ED9EBA1ul, r)
+#define R41C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f4(b, c, d), x, 0x8F1BBCDCul, r)
+#define R51C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f5(b, c, d), x, 0xA953FD4Eul, r)
+#define R12C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f5(b, c, d), x, 0x50A28BE6ul, r)
+#define R22C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f4(b, c, d), x, 0x5C4DD124ul, r)
+#define R32C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f3(b, c, d), x, 0x6D703EF3ul, r)
+#define R42C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f2(b, c, d), x, 0x7A6D76E9ul, r)
+#define R52C(a,b,c,d,e,x,r) RRoundC(a, b, c, d, e, f1(b, c, d), x, 0, r)
+
+void hash160sse_comp(const uint32_t *x, const uint32_t *odd, uint8_t *hash[4]) {
+
+  __m128i w[16];
+  __m128i s[8];
+
+  {
+
+    // SHA-256 message, big endian: 02|03, x, 0x80, zeros, 264
+    __m128i xw[8];
+    for (int j = 0; j < 8; j++)
+      xw[j] = LOADU(x + 4 * j);
+    w[0] = OR(SHL(ADD(LOADU(odd), SET1(2)), 24), SHR(xw[0], 8));
+    for (int j = 1; j < 8; j++)
+      w[j] = OR(SHL(xw[j - 1], 24), SHR(xw[j], 8));
+    w[8] = OR(SHL(xw[7], 24), SET1(0x00800000));
+
+    __m128i a, b, c, d, e, f, g, h;
+    __m128i T1;
+
+    // Round 0, the state is the constant IV
+    h = ADD(w[0], SET1(0xFC08884D));
+    d = ADD(w[0], SET1(0x98C7E2A2));
+    a = SET1(0x6A09E667);
+    b = SET1(0xBB67AE85);
+    c = SET1(0x3C6EF372);
+    e = SET1(0x510E527F);
+    f = SET1(0x9B05688C);
+    g = SET1(0x1F83D9AB);
+
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w[8]);
+    RoundC(h, a, b, c, d, e, f, g, 0x12835B01);
+    RoundC(g, h, a, b, c, d, e, f, 0x243185BE);
+    RoundC(f, g, h, a, b, c, d, e, 0x550C7DC3);
+    RoundC(e, f, g, h, a, b, c, d, 0x72BE5D74);
+    RoundC(d, e, f, g, h, a, b, c, 0x80DEB1FE);
+    RoundC(c, d, e, f, g, h, a, b, 0x9BDC06A7);
+    RoundC(b, c, d, e, f, g, h, a, 0xC19BF27C);
+
+    w[0] = ADD(s0(w[1]), w[0]);
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w[0]);
+    w[1] = ADD(ADD(s0(w[2]), w[1]), SET1(0x00A50000));
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w[1]);
+    w[2] = ADD(ADD(s1(w[0]), s0(w[3])), w[2]);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w[2]);
+    w[3] = ADD(ADD(s1(w[1]), s0(w[4])), w[3]);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w[3]);
+    w[4] = ADD(ADD(s1(w[2]), s0(w[5])), w[4]);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w[4]);
+    w[5] = ADD(ADD(s1(w[3]), s0(w[6])), w[5]);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w[5]);
+    w[6] = ADD(ADD(ADD(s1(w[4]), s0(w[7])), w[6]), SET1(0x00000108));
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w[6]);
+    w[7] = ADD(ADD(ADD(s1(w[5]), w[0]), s0(w[8])), w[7]);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w[7]);
+    w[8] = ADD(ADD(s1(w[6]), w[1]), w[8]);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w[8]);
+    w[9] = ADD(s1(w[7]), w[2]);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w[9]);
+    w[10] = ADD(s1(w[8]), w[3]);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w[10]);
+    w[11] = ADD(s1(w[9]), w[4]);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w[11]);
+    w[12] = ADD(s1(w[10]), w[5]);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w[12]);
+    w[13] = ADD(s1(w[11]), w[6]);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w[13]);
+    w[14] = ADD(ADD(s1(w[12]), w[7]), SET1(0x10420023));
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w[14]);
+    w[15] = ADD(ADD(ADD(s1(w[13]), w[8]), s0(w[0])), SET1(0x00000108));
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w[15]);
+    w[0] = ADD(ADD(ADD(s1(w[14]), w[9]), s0(w[1])), w[0]);
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w[0]);
+    w[1] = ADD(ADD(ADD(s1(w[15]), w[10]), s0(w[2])), w[1]);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w[1]);
+    w[2] = ADD(ADD(ADD(s1(w[0]), w[11]), s0(w[3])), w[2]);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w[2]);
+    w[3] = ADD(ADD(ADD(s1(w[1]), w[12]), s0(w[4])), w[3]);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w[3]);
+    w[4] = ADD(ADD(ADD(s1(w[2]), w[13]), s0(w[5])), w[4]);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w[4]);
+    w[5] = ADD(ADD(ADD(s1(w[3]), w[14]), s0(w[6])), w[5]);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w[5]);
+    w[6] = ADD(ADD(ADD(s1(w[4]), w[15]), s0(w[7])), w[6]);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w[6]);
+    w[7] = ADD(ADD(ADD(s1(w[5]), w[0]), s0(w[8])), w[7]);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w[7]);
+    w[8] = ADD(ADD(ADD(s1(w[6]), w[1]), s0(w[9])), w[8]);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w[8]);
+    w[9] = ADD(ADD(ADD(s1(w[7]), w[2]), s0(w[10])), w[9]);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w[9]);
+    w[10] = ADD(ADD(ADD(s1(w[8]), w[3]), s0(w[11])), w[10]);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w[10]);
+    w[11] = ADD(ADD(ADD(s1(w[9]), w[4]), s0(w[12])), w[11]);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w[11]);
+    w[12] = ADD(ADD(ADD(s1(w[10]), w[5]), s0(w[13])), w[12]);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w[12]);
+    w[13] = ADD(ADD(ADD(s1(w[11]), w[6]), s0(w[14])), w[13]);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w[13]);
+    w[14] = ADD(ADD(ADD(s1(w[12]), w[7]), s0(w[15])), w[14]);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w[14]);
+    w[15] = ADD(ADD(ADD(s1(w[13]), w[8]), s0(w[0])), w[15]);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w[15]);
+    w[0] = ADD(ADD(ADD(s1(w[14]), w[9]), s0(w[1])), w[0]);
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w[0]);
+    w[1] = ADD(ADD(ADD(s1(w[15]), w[10]), s0(w[2])), w[1]);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w[1]);
+    w[2] = ADD(ADD(ADD(s1(w[0]), w[11]), s0(w[3])), w[2]);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w[2]);
+    w[3] = ADD(ADD(ADD(s1(w[1]), w[12]), s0(w[4])), w[3]);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w[3]);
+    w[4] = ADD(ADD(ADD(s1(w[2]), w[13]), s0(w[5])), w[4]);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w[4]);
+    w[5] = ADD(ADD(ADD(s1(w[3]), w[14]), s0(w[6])), w[5]);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w[5]);
+    w[6] = ADD(ADD(ADD(s1(w[4]), w[15]), s0(w[7])), w[6]);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w[6]);
+    w[7] = ADD(ADD(ADD(s1(w[5]), w[0]), s0(w[8])), w[7]);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w[7]);
+    w[8] = ADD(ADD(ADD(s1(w[6]), w[1]), s0(w[9])), w[8]);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w[8]);
+    w[9] = ADD(ADD(ADD(s1(w[7]), w[2]), s0(w[10])), w[9]);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w[9]);
+    w[10] = ADD(ADD(ADD(s1(w[8]), w[3]), s0(w[11])), w[10]);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w[10]);
+    w[11] = ADD(ADD(ADD(s1(w[9]), w[4]), s0(w[12])), w[11]);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w[11]);
+    w[12] = ADD(ADD(ADD(s1(w[10]), w[5]), s0(w[13])), w[12]);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w[12]);
+    w[13] = ADD(ADD(ADD(s1(w[11]), w[6]), s0(w[14])), w[13]);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w[13]);
+    w[14] = ADD(ADD(ADD(s1(w[12]), w[7]), s0(w[15])), w[14]);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w[14]);
+    w[15] = ADD(ADD(ADD(s1(w[13]), w[8]), s0(w[0])), w[15]);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w[15]);
+
+    s[0] = ADD(a, SET1(0x6A09E667));
+    s[1] = ADD(b, SET1(0xBB67AE85));
+    s[2] = ADD(c, SET1(0x3C6EF372));
+    s[3] = ADD(d, SET1(0xA54FF53A));
+    s[4] = ADD(e, SET1(0x510E527F));
+    s[5] = ADD(f, SET1(0x9B05688C));
+    s[6] = ADD(g, SET1(0x1F83D9AB));
+    s[7] = ADD(h, SET1(0x5BE0CD19));
+
+  }
+
+  {
+
+    // RIPEMD-160 message, little endian: digest, 0x80, zeros, 256
+    __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    for (int j = 0; j < 8; j++)
+      w[j] = BSWAP(s[j]);
+
+    __m128i a1 = SET1(0x67452301ul);
+    __m128i b1 = SET1(0xEFCDAB89ul);
+    __m128i c1 = SET1(0x98BADCFEul);
+    __m128i d1 = SET1(0x10325476ul);
+    __m128i e1 = SET1(0xC3D2E1F0ul);
+    __m128i a2 = a1;
+    __m128i b2 = b1;
+    __m128i c2 = c1;
+    __m128i d2 = d1;
+    __m128i e2 = e1;
+    __m128i u;
+
+    R11(a1, b1, c1, d1, e1, w[0], 11);
+    R12(a2, b2, c2, d2, e2, w[5], 8);
+    R11(e1, a1, b1, c1, d1, w[1], 14);
+    R12C(e2, a2, b2, c2, d2, 256, 9);
+    R11(d1, e1, a1, b1, c1, w[2], 15);
+    R12(d2, e2, a2, b2, c2, w[7], 9);
+    R11(c1, d1, e1, a1, b1, w[3], 12);
+    R12(c2, d2, e2, a2, b2, w[0], 11);
+    R11(b1, c1, d1, e1, a1, w[4], 5);
+    R12C(b2, c2, d2, e2, a2, 0, 13);
+    R11(a1, b1, c1, d1, e1, w[5], 8);
+    R12(a2, b2, c2, d2, e2, w[2], 15);
+    R11(e1, a1, b1, c1, d1, w[6], 7);
+    R12C(e2, a2, b2, c2, d2, 0, 15);
+    R11(d1, e1, a1, b1, c1, w[7], 9);
+    R12(d2, e2, a2, b2, c2, w[4], 5);
+    R11C(c1, d1, e1, a1, b1, 0x80, 11);
+    R12C(c2, d2, e2, a2, b2, 0, 7);
+    R11C(b1, c1, d1, e1, a1, 0, 13);
+    R12(b2, c2, d2, e2, a2, w[6], 7);
+    R11C(a1, b1, c1, d1, e1, 0, 14);
+    R12C(a2, b2, c2, d2, e2, 0, 8);
+    R11C(e1, a1, b1, c1, d1, 0, 15);
+    R12C(e2, a2, b2, c2, d2, 0x80, 11);
+    R11C(d1, e1, a1, b1, c1, 0, 6);
+    R12(d2, e2, a2, b2, c2, w[1], 14);
+    R11C(c1, d1, e1, a1, b1, 0, 7);
+    R12C(c2, d2, e2, a2, b2, 0, 14);
+    R11C(b1, c1, d1, e1, a1, 256, 9);
+    R12(b2, c2, d2, e2, a2, w[3], 12);
+    R11C(a1, b1, c1, d1, e1, 0, 8);
+    R12C(a2, b2, c2, d2, e2, 0, 6);
+
+    R21(e1, a1, b1, c1, d1, w[7], 7);
+    R22(e2, a2, b2, c2, d2, w[6], 9);
+    R21(d1, e1, a1, b1, c1, w[4], 6);
+    R22C(d2, e2, a2, b2, c2, 0, 13);
+    R21C(c1, d1, e1, a1, b1, 0, 8);
+    R22(c2, d2, e2, a2, b2, w[3], 15);
+    R21(b1, c1, d1, e1, a1, w[1], 13);
+    R22(b2, c2, d2, e2, a2, w[7], 7);
+    R21C(a1, b1, c1, d1, e1, 0, 11);
+    R22(a2, b2, c2, d2, e2, w[0], 12);
+    R21(e1, a1, b1, c1, d1, w[6], 9);
+    R22C(e2, a2, b2, c2, d2, 0, 8);
+    R21C(d1, e1, a1, b1, c1, 0, 7);
+    R22(d2, e2, a2, b2, c2, w[5], 9);
+    R21(c1, d1, e1, a1, b1, w[3], 15);
+    R22C(c2, d2, e2, a2, b2, 0, 11);
+    R21C(b1, c1, d1, e1, a1, 0, 7);
+    R22C(b2, c2, d2, e2, a2, 256, 7);
+    R21(a1, b1, c1, d1, e1, w[0], 12);
+    R22C(a2, b2, c2, d2, e2, 0, 7);
+    R21C(e1, a1, b1, c1, d1, 0, 15);
+    R22C(e2, a2, b2, c2, d2, 0x80, 12);
+    R21(d1, e1, a1, b1, c1, w[5], 9);
+    R22C(d2, e2, a2, b2, c2, 0, 7);
+    R21(c1, d1, e1, a1, b1, w[2], 11);
+    R22(c2, d2, e2, a2, b2, w[4], 6);
+    R21C(b1, c1, d1, e1, a1, 256, 7);
+    R22C(b2, c2, d2, e2, a2, 0, 15);
+    R21C(a1, b1, c1, d1, e1, 0, 13);
+    R22(a2, b2, c2, d2, e2, w[1], 13);
+    R21C(e1, a1, b1, c1, d1, 0x80, 12);
+    R22(e2, a2, b2, c2, d2, w[2], 11);
+
+    R31(d1, e1, a1, b1, c1, w[3], 11);
+    R32C(d2, e2, a2, b2, c2, 0, 9);
+    R31C(c1, d1, e1, a1, b1, 0, 13);
+    R32(c2, d2, e2, a2, b2, w[5], 7);
+    R31C(b1, c1, d1, e1, a1, 256, 6);
+    R32(b2, c2, d2, e2, a2, w[1], 15);
+    R31(a1, b1, c1, d1, e1, w[4], 7);
+    R32(a2, b2, c2, d2, e2, w[3], 11);
+    R31C(e1, a1, b1, c1, d1, 0, 14);
+    R32(e2, a2, b2, c2, d2, w[7], 8);
+    R31C(d1, e1, a1, b1, c1, 0, 9);
+    R32C(d2, e2, a2, b2, c2, 256, 6);
+    R31C(c1, d1, e1, a1, b1, 0x80, 13);
+    R32(c2, d2, e2, a2, b2, w[6], 6);
+    R31(b1, c1, d1, e1, a1, w[1], 15);
+    R32C(b2, c2, d2, e2, a2, 0, 14);
+    R31(a1, b1, c1, d1, e1, w[2], 14);
+    R32C(a2, b2, c2, d2, e2, 0, 12);
+    R31(e1, a1, b1, c1, d1, w[7], 8);
+    R32C(e2, a2, b2, c2, d2, 0x80, 13);
+    R31(d1, e1, a1, b1, c1, w[0], 13);
+    R32C(d2, e2, a2, b2, c2, 0, 5);
+    R31(c1, d1, e1, a1, b1, w[6], 6);
+    R32(c2, d2, e2, a2, b2, w[2], 14);
+    R31C(b1, c1, d1, e1, a1, 0, 5);
+    R32C(b2, c2, d2, e2, a2, 0, 13);
+    R31C(a1, b1, c1, d1, e1, 0, 12);
+    R32(a2, b2, c2, d2, e2, w[0], 13);
+    R31(e1, a1, b1, c1, d1, w[5], 7);
+    R32(e2, a2, b2, c2, d2, w[4], 7);
+    R31C(d1, e1, a1, b1, c1, 0, 5);
+    R32C(d2, e2, a2, b2, c2, 0, 5);
+
+    R41(c1, d1, e1, a1, b1, w[1], 11);
+    R42C(c2, d2, e2, a2, b2, 0x80, 15);
+    R41C(b1, c1, d1, e1, a1, 0, 12);
+    R42(b2, c2, d2, e2, a2, w[6], 5);
+    R41C(a1, b1, c1, d1, e1, 0, 14);
+    R42(a2, b2, c2, d2, e2, w[4], 8);
+    R41C(e1, a1, b1, c1, d1, 0, 15);
+    R42(e2, a2, b2, c2, d2, w[1], 11);
+    R41(d1, e1, a1, b1, c1, w[0], 14);
+    R42(d2, e2, a2, b2, c2, w[3], 14);
+    R41C(c1, d1, e1, a1, b1, 0x80, 15);
+    R42C(c2, d2, e2, a2, b2, 0, 14);
+    R41C(b1, c1, d1, e1, a1, 0, 9);
+    R42C(b2, c2, d2, e2, a2, 0, 6);
+    R41(a1, b1, c1, d1, e1, w[4], 8);
+    R42(a2, b2, c2, d2, e2, w[0], 14);
+    R41C(e1, a1, b1, c1, d1, 0, 9);
+    R42(e2, a2, b2, c2, d2, w[5], 6);
+    R41(d1, e1, a1, b1, c1, w[3], 14);
+    R42C(d2, e2, a2, b2, c2, 0, 9);
+    R41(c1, d1, e1, a1, b1, w[7], 5);
+    R42(c2, d2, e2, a2, b2, w[2], 12);
+    R41C(b1, c1, d1, e1, a1, 0, 6);
+    R42C(b2, c2, d2, e2, a2, 0, 9);
+    R41C(a1, b1, c1, d1, e1, 256, 8);
+    R42C(a2, b2, c2, d2, e2, 0, 12);
+    R41(e1, a1, b1, c1, d1, w[5], 6);
+    R42(e2, a2, b2, c2, d2, w[7], 5);
+    R41(d1, e1, a1, b1, c1, w[6], 5);
+    R42C(d2, e2, a2, b2, c2, 0, 15);
+    R41(c1, d1, e1, a1, b1, w[2], 12);
+    R42C(c2, d2, e2, a2, b2, 256, 8);
+
+    R51(b1, c1, d1, e1, a1, w[4], 9);
+    R52C(b2, c2, d2, e2, a2, 0, 8);
+    R51(a1, b1, c1, d1, e1, w[0], 15);
+    R52C(a2, b2, c2, d2, e2, 0, 5);
+    R51(e1, a1, b1, c1, d1, w[5], 5);
+    R52C(e2, a2, b2, c2, d2, 0, 12);
+    R51C(d1, e1, a1, b1, c1, 0, 11);
+    R52(d2, e2, a2, b2, c2, w[4], 9);
+    R51(c1, d1, e1, a1, b1, w[7], 6);
+    R52(c2, d2, e2, a2, b2, w[1], 12);
+    R51C(b1, c1, d1, e1, a1, 0, 8);
+    R52(b2, c2, d2, e2, a2, w[5], 5);
+    R51(a1, b1, c1, d1, e1, w[2], 13);
+    R52C(a2, b2, c2, d2, e2, 0x80, 14);
+    R51C(e1, a1, b1, c1, d1, 0, 12);
+    R52(e2, a2, b2, c2, d2, w[7], 6);
+    R51C(d1, e1, a1, b1, c1, 256, 5);
+    R52(d2, e2, a2, b2, c2, w[6], 8);
+    R51(c1, d1, e1, a1, b1, w[1], 12);
+    R52(c2, d2, e2, a2, b2, w[2], 13);
+    R51(b1, c1, d1, e1, a1, w[3], 13);
+    R52C(b2, c2, d2, e2, a2, 0, 6);
+    R51C(a1, b1, c1, d1, e1, 0x80, 14);
+    R52C(a2, b2, c2, d2, e2, 256, 5);
+    R51C(e1, a1, b1, c1, d1, 0, 11);
+    R52(e2, a2, b2, c2, d2, w[0], 15);
+    R51(d1, e1, a1, b1, c1, w[6], 8);
+    R52(d2, e2, a2, b2, c2, w[3], 13);
+    R51C(c1, d1, e1, a1, b1, 0, 5);
+    R52C(c2, d2, e2, a2, b2, 0, 11);
+    R51C(b1, c1, d1, e1, a1, 0, 6);
+    R52C(b2, c2, d2, e2, a2, 0, 11);
+
+    s[0] = add3(SET1(0xEFCDAB89ul), c1, d2);
+    s[1] = add3(SET1(0x98BADCFEul), d1, e2);
+    s[2] = add3(SET1(0x10325476ul), e1, a2);
+    s[3] = add3(SET1(0xC3D2E1F0ul), a1, b2);
+    s[4] = add3(SET1(0x67452301ul), b1, c2);
+
+  }
+
+  uint32_t r[5][4];
+  for (int i = 0; i < 5; i++)
+    STOREU(r[i], s[i]);
+  for (int j = 0; j < 4; j++) {
+    ((uint32_t *)hash[j])[0] = r[0][j];
+    ((uint32_t *)hash[j])[1] = r[1][j];
+    ((uint32_t *)hash[j])[2] = r[2][j];
+    ((uint32_t *)hash[j])[3] = r[3][j];
+    ((uint32_t *)hash[j])[4] = r[4][j];
+  }
+
+}
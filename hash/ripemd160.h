@@ -41,6 +41,10 @@ void ripemd160_32(unsigned char *input, unsigned char *digest);
 void ripemd160sse_32(uint8_t *i0, uint8_t *i1, uint8_t *i2, uint8_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
 void ripemd160sse_test();
+// 8 lanes AVX2 version (AVX2 CPU only), the inputs are not padded
+void ripemd160avx2_32(uint8_t *i[8], uint8_t *d[8]);
+// 16 lanes AVX-512 version (AVX-512F CPU only)
+void ripemd160avx512_32(uint8_t *i[16], uint8_t *d[16]);
 std::string ripemd160_hex(unsigned char *digest);
 
 static inline bool ripemd160_comp_hash(uint8_t *h0, uint8_t *h1) {
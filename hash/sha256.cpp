@@ -82,7 +82,7 @@ inline uint32_t _rotr(uint32_t x, uint8_t r) {
 
 
   // Perform SHA-256 transformations, process 64-byte chunks
-  void Transform(uint32_t* s, const unsigned char* chunk)
+  void TransformScalar(uint32_t* s, const unsigned char* chunk)
   {
     uint32_t t1;
     uint32_t t2;
@@ -350,8 +350,46 @@ inline uint32_t _rotr(uint32_t x, uint8_t r) {
 
   }
 
+  // SHA-NI transform when the CPU supports it
+  static bool shaNi = sha256shani_supported();
+
+  // Process nbBlock 64-byte chunks
+  inline void Transform(uint32_t *s, const unsigned char *chunk, size_t nbBlock = 1) {
+    if (shaNi) {
+      sha256shani_transform(s, chunk, nbBlock);
+    } else {
+      for (size_t i = 0; i < nbBlock; i++)
+        TransformScalar(s, chunk + 64 * i);
+    }
+  }
+
+  // Compute SHA256(SHA256(chunk))[0], dispatched as Transform()
+  inline void Checksum(uint32_t *s, const unsigned char *chunk) {
+
+    if (!shaNi) {
+      Transform2(s, chunk);
+      return;
+    }
+
+    unsigned char b[64];
+    Initialize(s);
+    sha256shani_transform(s, chunk, 1);
+    for (int i = 0; i < 8; i++)
+      WRITEBE32(b + 4 * i, s[i]);
+    memcpy(b + 32, pad, 24);
+    WRITEBE64(b + 56, (uint64_t)256);
+    Initialize(s);
+    sha256shani_transform(s, b, 1);
+
+  }
+
 } // namespace sha256
 
+bool sha256_use_shani(bool enable) {
+  _sha256::shaNi = enable && sha256shani_supported();
+  return _sha256::shaNi;
+}
+
 
 ////// SHA-256
 
@@ -395,11 +433,12 @@ void CSHA256::Write(const unsigned char* data, size_t len)
     _sha256::Transform(s, buf);
     bufsize = 0;
   }
-  while (end >= data + 64) {
+  if (end >= data + 64) {
     // Process full chunks directly from the source.
-    _sha256::Transform(s, data);
-    bytes += 64;
-    data += 64;
+    size_t nbBlock = (end - data) / 64;
+    _sha256::Transform(s, data, nbBlock);
+    bytes += 64 * nbBlock;
+    data += 64 * nbBlock;
   }
   if (end > data) {
     // Fill the buffer with what remains.
@@ -465,8 +504,7 @@ void sha256_65(unsigned char *input, unsigned char *digest) {
   memcpy(input + 120, sizedesc_65, 8);
 
   _sha256::Initialize(s);
-  _sha256::Transform(s, input);
-  _sha256::Transform(s, input+64);
+  _sha256::Transform(s, input, 2);
 
   WRITEBE32(digest, s[0]);
   WRITEBE32(digest + 4, s[1]);
@@ -486,7 +524,7 @@ void sha256_checksum(uint8_t *input, int length, uint8_t *checksum) {
   memcpy(b,input,length);
   memcpy(b + length, _sha256::pad, 56-length);
   WRITEBE64(b + 56, length << 3);
-  _sha256::Transform2(s, b);
+  _sha256::Checksum(s, b);
   WRITEBE32(checksum,s[0]);
 
 }
@@ -30,6 +30,20 @@ void sha256sse_2B(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
 void sha256sse_checksum(uint32_t *i0, uint32_t *i1, uint32_t *i2, uint32_t *i3,
   uint8_t *d0, uint8_t *d1, uint8_t *d2, uint8_t *d3);
+// 8 lanes AVX2 versions (AVX2 CPU only), lane j is i[j] -> d[j]
+void sha256avx2_1B(uint32_t *i[8], uint8_t *d[8]);
+void sha256avx2_2B(uint32_t *i[8], uint8_t *d[8]);
+void sha256avx2_checksum(uint32_t *i[8], uint8_t *d[8]);
+// 16 lanes AVX-512 versions (AVX-512F CPU only)
+void sha256avx512_1B(uint32_t *i[16], uint8_t *d[16]);
+void sha256avx512_2B(uint32_t *i[16], uint8_t *d[16]);
+void sha256avx512_checksum(uint32_t *i[16], uint8_t *d[16]);
+// SHA-NI single buffer transform, used by the functions above when the
+// CPU supports it. sha256_use_shani() switches it (for checks and benchmarks)
+// and returns true if SHA-NI is used.
+bool sha256shani_supported();
+void sha256shani_transform(uint32_t *s, const unsigned char *chunk, size_t nbBlock);
+bool sha256_use_shani(bool enable);
 std::string sha256_hex(unsigned char *digest);
 void sha256sse_test();
 
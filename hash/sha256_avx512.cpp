@@ -0,0 +1,491 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef WIN64
+// Compiled for AVX-512 whatever -march, only called when the CPU has it
+#pragma GCC target("avx512f")
+#endif
+
+namespace _sha256avx512
+{
+
+#ifdef WIN64
+  static const __declspec(align(64)) uint32_t _init[] = {
+#else
+  static const uint32_t _init[] __attribute__ ((aligned (64))) = {
+#endif
+      0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,0x6a09e667,
+      0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,0xbb67ae85,
+      0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,0x3c6ef372,
+      0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,0xa54ff53a,
+      0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,0x510e527f,
+      0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,0x9b05688c,
+      0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,0x1f83d9ab,
+      0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19,0x5be0cd19
+  };
+
+  // 16x16 transpose of 32 bits words, r[i] lane j <-> r[j] lane i
+  static inline void Transpose(__m512i *r) {
+
+    __m512i t[16];
+    __m512i u[16];
+
+    for (int i = 0; i < 16; i += 2) {
+      t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+      t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 16; i += 4) {
+      u[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+      u[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+      u[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+      u[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    // u[4q+m] 128 bits lane k holds the words 4k+m of the rows 4q..4q+3
+    for (int m = 0; m < 4; m++) {
+      __m512i v0 = _mm512_shuffle_i32x4(u[m], u[4 + m], 0x88);
+      __m512i v1 = _mm512_shuffle_i32x4(u[m], u[4 + m], 0xDD);
+      __m512i v2 = _mm512_shuffle_i32x4(u[8 + m], u[12 + m], 0x88);
+      __m512i v3 = _mm512_shuffle_i32x4(u[8 + m], u[12 + m], 0xDD);
+      r[m] = _mm512_shuffle_i32x4(v0, v2, 0x88);
+      r[4 + m] = _mm512_shuffle_i32x4(v1, v3, 0x88);
+      r[8 + m] = _mm512_shuffle_i32x4(v0, v2, 0xDD);
+      r[12 + m] = _mm512_shuffle_i32x4(v1, v3, 0xDD);
+    }
+
+  }
+
+  // Message words of the 16 blocks, lane j is blk[j]
+  static inline void LoadW(__m512i *w, uint32_t *blk[16]) {
+    for (int j = 0; j < 16; j++)
+      w[j] = _mm512_loadu_si512((__m512i *)blk[j]);
+    Transpose(w);
+  }
+
+// Maj and Ch are single vpternlogd, the rotations are vprord
+#define Maj(b,c,d) _mm512_ternarylogic_epi32(b, c, d, 0xE8)
+#define Ch(b,c,d)  _mm512_ternarylogic_epi32(b, c, d, 0xCA)
+#define ROR(x,n)   _mm512_ror_epi32(x, n)
+#define SHR(x,n)   _mm512_srli_epi32(x, n)
+#define XOR3(x,y,z) _mm512_ternarylogic_epi32(x, y, z, 0x96)
+
+  /* SHA256 Functions */
+#define	S0(x) XOR3(ROR((x), 2), ROR((x), 13), ROR((x), 22))
+#define	S1(x) XOR3(ROR((x), 6), ROR((x), 11), ROR((x), 25))
+#define	s0(x) XOR3(ROR((x), 7), ROR((x), 18), SHR((x), 3))
+#define	s1(x) XOR3(ROR((x), 17), ROR((x), 19), SHR((x), 10))
+
+#define add4(x0, x1, x2, x3) _mm512_add_epi32(_mm512_add_epi32(x0, x1), _mm512_add_epi32(x2, x3))
+#define add3(x0, x1, x2 ) _mm512_add_epi32(_mm512_add_epi32(x0, x1), x2)
+#define add5(x0, x1, x2, x3, x4) _mm512_add_epi32(add3(x0, x1, x2), _mm512_add_epi32(x3, x4))
+
+
+#define	Round(a, b, c, d, e, f, g, h, i, w)                 \
+    T1 = add5(h, S1(e), Ch(e, f, g), _mm512_set1_epi32(i), w);	\
+    d = _mm512_add_epi32(d, T1);                               \
+    T2 = _mm512_add_epi32(S0(a), Maj(a, b, c));                \
+    h = _mm512_add_epi32(T1, T2);
+
+#define WMIX() \
+  w[0] = add4(s1(w[14]), w[9], s0(w[1]), w[0]); \
+  w[1] = add4(s1(w[15]), w[10], s0(w[2]), w[1]); \
+  w[2] = add4(s1(w[0]), w[11], s0(w[3]), w[2]); \
+  w[3] = add4(s1(w[1]), w[12], s0(w[4]), w[3]); \
+  w[4] = add4(s1(w[2]), w[13], s0(w[5]), w[4]); \
+  w[5] = add4(s1(w[3]), w[14], s0(w[6]), w[5]); \
+  w[6] = add4(s1(w[4]), w[15], s0(w[7]), w[6]); \
+  w[7] = add4(s1(w[5]), w[0], s0(w[8]), w[7]); \
+  w[8] = add4(s1(w[6]), w[1], s0(w[9]), w[8]); \
+  w[9] = add4(s1(w[7]), w[2], s0(w[10]), w[9]); \
+  w[10] = add4(s1(w[8]), w[3], s0(w[11]), w[10]); \
+  w[11] = add4(s1(w[9]), w[4], s0(w[12]), w[11]); \
+  w[12] = add4(s1(w[10]), w[5], s0(w[13]), w[12]); \
+  w[13] = add4(s1(w[11]), w[6], s0(w[14]), w[13]); \
+  w[14] = add4(s1(w[12]), w[7], s0(w[15]), w[14]); \
+  w[15] = add4(s1(w[13]), w[8], s0(w[0]), w[15]);
+
+  // Initialise state
+  void Initialize(__m512i *s) {
+    memcpy(s, _init, sizeof(_init));
+  }
+
+  // Perform 16 SHA in parallel using AVX-512
+  void Transform(__m512i *s, uint32_t *blk[16])
+  {
+    __m512i a,b,c,d,e,f,g,h;
+    __m512i w[16];
+    __m512i T1, T2;
+
+    a = _mm512_load_si512(s + 0);
+    b = _mm512_load_si512(s + 1);
+    c = _mm512_load_si512(s + 2);
+    d = _mm512_load_si512(s + 3);
+    e = _mm512_load_si512(s + 4);
+    f = _mm512_load_si512(s + 5);
+    g = _mm512_load_si512(s + 6);
+    h = _mm512_load_si512(s + 7);
+
+    LoadW(w, blk);
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w[15]);
+
+    s[0] = _mm512_add_epi32(a, s[0]);
+    s[1] = _mm512_add_epi32(b, s[1]);
+    s[2] = _mm512_add_epi32(c, s[2]);
+    s[3] = _mm512_add_epi32(d, s[3]);
+    s[4] = _mm512_add_epi32(e, s[4]);
+    s[5] = _mm512_add_epi32(f, s[5]);
+    s[6] = _mm512_add_epi32(g, s[6]);
+    s[7] = _mm512_add_epi32(h, s[7]);
+
+  }
+
+  // Perform 16 SHA(SHA(bi))[0] in parallel using AVX-512
+  void Transform2(__m512i *s, uint32_t *blk[16]) {
+    __m512i a, b, c, d, e, f, g, h;
+    __m512i w[16];
+    __m512i T1, T2;
+
+    a = _mm512_load_si512(s + 0);
+    b = _mm512_load_si512(s + 1);
+    c = _mm512_load_si512(s + 2);
+    d = _mm512_load_si512(s + 3);
+    e = _mm512_load_si512(s + 4);
+    f = _mm512_load_si512(s + 5);
+    g = _mm512_load_si512(s + 6);
+    h = _mm512_load_si512(s + 7);
+
+    LoadW(w, blk);
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w[15]);
+
+    w[0] = _mm512_add_epi32(a, s[0]);
+    w[1] = _mm512_add_epi32(b, s[1]);
+    w[2] = _mm512_add_epi32(c, s[2]);
+    w[3] = _mm512_add_epi32(d, s[3]);
+    w[4] = _mm512_add_epi32(e, s[4]);
+    w[5] = _mm512_add_epi32(f, s[5]);
+    w[6] = _mm512_add_epi32(g, s[6]);
+    w[7] = _mm512_add_epi32(h, s[7]);
+    w[8] = _mm512_set1_epi32(0x80000000);
+    w[9] = _mm512_xor_si512(w[9],w[9]);
+    w[10] = _mm512_xor_si512(w[10], w[10]);
+    w[11] = _mm512_xor_si512(w[11], w[11]);
+    w[12] = _mm512_xor_si512(w[12], w[12]);
+    w[13] = _mm512_xor_si512(w[13], w[13]);
+    w[14] = _mm512_xor_si512(w[14], w[14]);
+    w[15] = _mm512_set1_epi32(0x100);
+
+    a = _mm512_load_si512(s + 0);
+    b = _mm512_load_si512(s + 1);
+    c = _mm512_load_si512(s + 2);
+    d = _mm512_load_si512(s + 3);
+    e = _mm512_load_si512(s + 4);
+    f = _mm512_load_si512(s + 5);
+    g = _mm512_load_si512(s + 6);
+    h = _mm512_load_si512(s + 7);
+
+    Round(a, b, c, d, e, f, g, h, 0x428A2F98, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x71374491, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0xB5C0FBCF, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0xE9B5DBA5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x3956C25B, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x59F111F1, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x923F82A4, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0xAB1C5ED5, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xD807AA98, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x12835B01, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x243185BE, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x550C7DC3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x72BE5D74, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0x80DEB1FE, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x9BDC06A7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC19BF174, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0xE49B69C1, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0xEFBE4786, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x0FC19DC6, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x240CA1CC, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x2DE92C6F, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4A7484AA, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5CB0A9DC, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x76F988DA, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x983E5152, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA831C66D, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xB00327C8, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xBF597FC7, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xC6E00BF3, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD5A79147, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0x06CA6351, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x14292967, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x27B70A85, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x2E1B2138, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x4D2C6DFC, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x53380D13, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x650A7354, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x766A0ABB, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x81C2C92E, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x92722C85, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0xA2BFE8A1, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0xA81A664B, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0xC24B8B70, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0xC76C51A3, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0xD192E819, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xD6990624, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xF40E3585, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0x106AA070, w[15]);
+
+    WMIX()
+
+    Round(a, b, c, d, e, f, g, h, 0x19A4C116, w[0]);
+    Round(h, a, b, c, d, e, f, g, 0x1E376C08, w[1]);
+    Round(g, h, a, b, c, d, e, f, 0x2748774C, w[2]);
+    Round(f, g, h, a, b, c, d, e, 0x34B0BCB5, w[3]);
+    Round(e, f, g, h, a, b, c, d, 0x391C0CB3, w[4]);
+    Round(d, e, f, g, h, a, b, c, 0x4ED8AA4A, w[5]);
+    Round(c, d, e, f, g, h, a, b, 0x5B9CCA4F, w[6]);
+    Round(b, c, d, e, f, g, h, a, 0x682E6FF3, w[7]);
+    Round(a, b, c, d, e, f, g, h, 0x748F82EE, w[8]);
+    Round(h, a, b, c, d, e, f, g, 0x78A5636F, w[9]);
+    Round(g, h, a, b, c, d, e, f, 0x84C87814, w[10]);
+    Round(f, g, h, a, b, c, d, e, 0x8CC70208, w[11]);
+    Round(e, f, g, h, a, b, c, d, 0x90BEFFFA, w[12]);
+    Round(d, e, f, g, h, a, b, c, 0xA4506CEB, w[13]);
+    Round(c, d, e, f, g, h, a, b, 0xBEF9A3F7, w[14]);
+    Round(b, c, d, e, f, g, h, a, 0xC67178F2, w[15]);
+
+    s[0] = _mm512_add_epi32(a, s[0]);
+
+  }
+
+} // end namespace
+
+// Big endian state of the 16 lanes to the 32 bytes digests
+static inline void StoreDigest(__m512i *s, unsigned char *d[16]) {
+
+  __m512i r[16];
+  __m512i mask = _mm512_set1_epi32(0xFF00FF00);
+
+  for (int j = 0; j < 8; j++) {
+    r[j] = s[j];
+    r[j + 8] = _mm512_setzero_si512();
+  }
+  _sha256avx512::Transpose(r);
+  for (int j = 0; j < 16; j++) {
+    // bswap32(x) = (x ror 8) & 0xFF00FF00 | (x rol 8) & 0x00FF00FF
+    __m512i x = _mm512_ternarylogic_epi32(_mm512_ror_epi32(r[j], 8), _mm512_rol_epi32(r[j], 8), mask, 0xE4);
+    _mm256_storeu_si256((__m256i *)d[j], _mm512_castsi512_si256(x));
+  }
+
+}
+
+void sha256avx512_1B(uint32_t *i[16], unsigned char *d[16]) {
+
+  __m512i s[8];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, i);
+  StoreDigest(s, d);
+
+}
+
+void sha256avx512_2B(uint32_t *i[16], unsigned char *d[16]) {
+
+  __m512i s[8];
+  uint32_t *i2[16];
+
+  for (int j = 0; j < 16; j++)
+    i2[j] = i[j] + 16;
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform(s, i);
+  _sha256avx512::Transform(s, i2);
+  StoreDigest(s, d);
+
+}
+
+void sha256avx512_checksum(uint32_t *i[16], uint8_t *d[16]) {
+
+  __m512i s[8];
+
+  _sha256avx512::Initialize(s);
+  _sha256avx512::Transform2(s, i);
+
+#ifndef WIN64
+  uint32_t *s32 = (uint32_t *)(&s[0]);
+  for (int j = 0; j < 16; j++)
+    *((uint32_t *)d[j]) = __builtin_bswap32(s32[j]);
+#else
+  for (int j = 0; j < 16; j++)
+    *((uint32_t *)d[j]) = _byteswap_ulong(s[0].m512i_u32[j]);
+#endif
+
+}
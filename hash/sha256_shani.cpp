@@ -0,0 +1,160 @@
+/*
+ * This file is part of the VanitySearch distribution (https://github.com/JeanLucPons/VanitySearch).
+ * Copyright (c) 2019 Jean Luc PONS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sha256.h"
+#include <immintrin.h>
+#include <stdint.h>
+#ifdef WIN64
+#include <intrin.h>
+#define SHANI_TARGET
+#else
+#include <cpuid.h>
+// Compiled for SHA-NI whatever -march, only called when the CPU has it
+#define SHANI_TARGET __attribute__((target("sha,sse4.1")))
+#endif
+
+namespace _sha256shani
+{
+
+  static const uint32_t K[] = {
+    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+  };
+
+} // end namespace
+
+bool sha256shani_supported() {
+
+  // SHA (CPUID.7.0:EBX[29]), SSSE3 (CPUID.1:ECX[9]) and SSE4.1 (CPUID.1:ECX[19])
+#ifdef WIN64
+  int r[4];
+  __cpuid(r, 0);
+  if (r[0] < 7)
+    return false;
+  __cpuidex(r, 7, 0);
+  bool sha = (r[1] >> 29) & 1;
+  __cpuid(r, 1);
+  return sha && ((r[2] >> 9) & 1) && ((r[2] >> 19) & 1);
+#else
+  unsigned int a, b, c, d;
+  if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+    return false;
+  bool sha = (b >> 29) & 1;
+  if (!__get_cpuid(1, &a, &b, &c, &d))
+    return false;
+  return sha && ((c >> 9) & 1) && ((c >> 19) & 1);
+#endif
+
+}
+
+// 4 rounds on the words w (+K), the second rnds2 takes the upper 2 words
+#define Round4(i, w) \
+  msg = _mm_add_epi32(w, _mm_loadu_si128((const __m128i *)(_sha256shani::K + 4 * (i)))); \
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+  msg = _mm_shuffle_epi32(msg, 0x0E); \
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+// Same with the end of the schedule of next: w[t] = s1(w[t-2]) + w[t-7] + ...
+#define Round4M(i, w, prev, next) \
+  msg = _mm_add_epi32(w, _mm_loadu_si128((const __m128i *)(_sha256shani::K + 4 * (i)))); \
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+  next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(w, prev, 4)), w); \
+  msg = _mm_shuffle_epi32(msg, 0x0E); \
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+// Start of the schedule: ... + s0(w[t-15]) + w[t-16]
+#define MSG1(w, wn) w = _mm_sha256msg1_epu32(w, wn);
+
+// Same state layout as _sha256::Transform (s[0] = a ... s[7] = h), the
+// sha256rnds2 instruction works on the ABEF and CDGH halves
+SHANI_TARGET void sha256shani_transform(uint32_t *s, const unsigned char *chunk, size_t nbBlock) {
+
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i m0, m1, m2, m3;
+  __m128i msg;
+
+#ifdef __AVX__
+  // The sha256 instructions have no VEX encoding, a dirty upper state (from
+  // the AVX2/AVX-512 kernels) makes every legacy SSE instruction very slow
+  _mm256_zeroupper();
+#endif
+
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)s), 0xB1);         // CDAB
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(s + 4)), 0x1B); // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                                  // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);                                        // CDGH
+
+  for (size_t n = 0; n < nbBlock; n++, chunk += 64) {
+
+    __m128i abef = state0;
+    __m128i cdgh = state1;
+
+    // 4 rounds per step: the schedule of the next words is completed
+    // (msg2) and the one of the previous words started (msg1) alongside
+    m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(chunk + 0)), mask);
+    m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(chunk + 16)), mask);
+    m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(chunk + 32)), mask);
+    m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(chunk + 48)), mask);
+
+    Round4(0, m0);
+    Round4(1, m1);
+    MSG1(m0, m1);
+    Round4(2, m2);
+    MSG1(m1, m2);
+    Round4M(3, m3, m2, m0);
+    MSG1(m2, m3);
+    Round4M(4, m0, m3, m1);
+    MSG1(m3, m0);
+    Round4M(5, m1, m0, m2);
+    MSG1(m0, m1);
+    Round4M(6, m2, m1, m3);
+    MSG1(m1, m2);
+    Round4M(7, m3, m2, m0);
+    MSG1(m2, m3);
+    Round4M(8, m0, m3, m1);
+    MSG1(m3, m0);
+    Round4M(9, m1, m0, m2);
+    MSG1(m0, m1);
+    Round4M(10, m2, m1, m3);
+    MSG1(m1, m2);
+    Round4M(11, m3, m2, m0);
+    MSG1(m2, m3);
+    Round4M(12, m0, m3, m1);
+    MSG1(m3, m0);
+    Round4M(13, m1, m0, m2);
+    Round4M(14, m2, m1, m3);
+    Round4(15, m3);
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);      // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);   // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);   // HGFE
+  _mm_storeu_si128((__m128i *)s, state0);
+  _mm_storeu_si128((__m128i *)(s + 4), state1);
+
+}
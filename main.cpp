@@ -18,7 +18,11 @@
 
 #include <sstream> 
 #include "Timer.h"
+#include "CPUFeatures.h"
 #include "Vanity.h"
+#include "ChunkMap.h"
+#include "Coordinator.h"
+#include "TargetDB.h"
 #include "SECP256k1.h"
 #include <fstream>
 #include <string>
@@ -39,8 +43,8 @@
 
 std::atomic<bool> Pause(false);
 std::atomic<bool> Paused(false);
+std::atomic<bool> Reload(false);
 std::atomic<bool> stopMonitorKey(false);
-int idxcount;
 double t_Paused;
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -54,6 +58,8 @@ void monitorKeypress() {
 				//printf("\nPause PRESSED\n");
 				//break;
 			}
+			if (ch == 'r' || ch == 'R')
+				Reload = true;
 		}
 	}
 }
@@ -92,6 +98,8 @@ void monitorKeypress() {
 			if (ch == 'p' || ch == 'P') {
 				Pause = !Pause;
 			}
+			if (ch == 'r' || ch == 'R')
+				Reload = true;
 		}
 	}
 
@@ -111,14 +119,37 @@ void printUsage() {
     printf("Usage: VanitySearch [options]\n");
     printf("Options:\n");
     printf("  -v          Print version\n");
+    printf("  -check      Check CPU and GPU kernel vs CPU\n");
+    printf("  -bench      Benchmark the hash160 kernels, the base58 encoder, the CPU lookup probes and the pattern matcher\n");
     printf("  -gpuId      GPU to use, default is 0\n");
     printf("  -batchSize  Batch size for GPU processing, default is 1\n");
-    printf("  -i          Input file with addresses to search\n");
+    printf("  -t          Number of CPU threads, default is 0 (number of cores without GPU support)\n");
+    printf("  -nogpu      Do not use the GPU, search with CPU threads only\n");
+    printf("  -i          Input file with addresses to search, press r to reload it while searching\n");
+    printf("  -watch      Reload the input file when it changes, the search goes on\n");
+    printf("  -db         Target database (sorted hash160) made by -convert\n");
+    printf("  -convert in out  Convert the full addresses of in to a target database and exit\n");
     printf("  -o          Output file for results\n");
     printf("  -start      Starting private key in HEX\n");
     printf("  -range      Bit range dimension (start -> start + 2^range)\n");
     printf("  -m          Max number of prefixes found per kernel call (default: 262144)\n");
     printf("  -stop       Stop when all prefixes are found\n");
+    printf("  -u          Search uncompressed addresses (CPU only)\n");
+    printf("  -b          Search both compressed and uncompressed addresses (CPU only)\n");
+    printf("  -endo       CPU threads also check the endomorphism and symmetric keys (prefix search)\n");
+    printf("  -xor        CPU threads use a xor filter on the full hash160 (full addresses)\n");
+    printf("  -c          Case insensitive search of the P2PKH/P2SH prefixes\n");
+    printf("  -cp         Checkpoint file, progress is saved periodically\n");
+    printf("  -cpi        Checkpoint interval in seconds, default is 60\n");
+    printf("  -resume     Resume the search saved in a checkpoint file\n");
+    printf("  -chunk      Split the range in 2^chunk keys chunks visited in random order\n");
+    printf("  -chunkmap   Chunk map file shared by all processes, default is chunks.map\n");
+    printf("  -chunkretake Search again the chunks left unfinished by interrupted processes\n");
+    printf("  -coordinator [addr:]port  Lease the chunks of the range to workers, needs -chunk,\n");
+    printf("              listens on 127.0.0.1 unless addr is given (0.0.0.0 for all interfaces)\n");
+    printf("  -worker host:port  Search the chunks leased by a coordinator\n");
+    printf("  -lease      Coordinator lease duration in seconds, default is 600\n");
+    printf("  -token      Shared secret of the coordinator and its workers\n");
     exit(-1);
 }
 
@@ -526,6 +557,14 @@ int main(int argc, char* argv[]) {
 
 	// Global Init
 	Timer::Init();
+	rseed(Timer::getSeed32());
+
+	// SIMD kernels of the CPU, the SSE ones are the baseline
+	CPUFeatures::Init();
+	if (!CPUFeatures::ssse3 || !CPUFeatures::sse41) {
+		fprintf(stderr, "[ERROR] VanitySearch: CPU without SSSE3/SSE4.1\n");
+		exit(-1);
+	}
 
 	// Init SecpK1
 	Secp256K1* secp = new Secp256K1();
@@ -550,6 +589,32 @@ int main(int argc, char* argv[]) {
 	int range = 30;
 	string start = "0";
 	int batchSize = 8;
+	string checkpointFile = "";
+	int checkpointInterval = 60;
+	bool resume = false;
+	int chunkBits = 0;
+	string chunkMapFile = "chunks.map";
+	bool chunkRetake = false;
+	bool useEndo = false;
+	bool useFilter = false;
+	bool caseSensitive = true;
+	string dbFile = "";
+	string inputFile = "";
+	bool watchInput = false;
+	int coordinatorPort = 0;
+	string coordinatorBind = COORDINATOR_BIND;
+	string token = "";
+	string workerHost = "";
+	int workerPort = 0;
+	int leaseTime = 600;
+#ifdef WITHGPU
+	int nbCPUThread = 0;
+	bool gpuEnable = true;
+#else
+	int nbCPUThread = Timer::getCoreNumber();
+	bool gpuEnable = false;
+#endif
+	bool tSpecified = false;
 	
 	// bitcrack mod
 	BITCRACK_PARAM bitcrack, *bc;
@@ -575,6 +640,40 @@ int main(int argc, char* argv[]) {
 			gpuParsed = string(argv[a]);
 			a++;
 		}
+		else if (strcmp(argv[a], "-t") == 0) {
+			a++;
+			nbCPUThread = getInt("nbCPUThread", argv[a]);
+			tSpecified = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-nogpu") == 0) {
+			gpuEnable = false;
+			a++;
+		}
+		else if (strcmp(argv[a], "-check") == 0) {
+			secp->Check();
+			CPUEngine c(secp, 64, maxFound);
+			bool ok = c.Check(secp);
+			XorFilter f;
+			ok = f.Check() && ok;
+			PatternMatcher m;
+			ok = m.Check(secp) && ok;
+#ifdef WITHGPU
+			GPUEngine g(gpuId[0], maxFound, batchSize);
+			g.SetSearchMode(searchMode);
+			ok = g.Check(secp) && ok;
+#else
+			printf("GPU code not compiled, use -DWITHGPU when compiling.\n");
+#endif
+			exit(ok ? 0 : -1);
+		}
+		else if (strcmp(argv[a], "-bench") == 0) {
+			secp->BenchHash160();
+			CPUEngine c(secp, 1, maxFound);
+			c.BenchProbe();
+			PatternMatcher::Bench(secp);
+			exit(0);
+		}
 		else if (strcmp(argv[a], "-v") == 0) {
 			printf("%s\n", RELEASE);
 			exit(0);
@@ -592,19 +691,119 @@ int main(int argc, char* argv[]) {
 		}
 		else if (strcmp(argv[a], "-i") == 0) {
 			a++;
-			parseFile(string(argv[a]), address);
+			inputFile = string(argv[a]);
+			parseFile(inputFile, address);
 			a++;
 
 		}
+		else if (strcmp(argv[a], "-watch") == 0) {
+			watchInput = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-db") == 0) {
+			a++;
+			dbFile = string(argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-convert") == 0) {
+			if (a + 2 >= argc) {
+				fprintf(stderr, "[ERROR] -convert needs an input and an output file\n");
+				exit(-1);
+			}
+			exit(TargetDB::Convert(string(argv[a + 1]), string(argv[a + 2])) ? 0 : -1);
+		}
 		else if (strcmp(argv[a], "-stop") == 0) {
 			stop = true;
 			a++;
 		}
+		else if (strcmp(argv[a], "-u") == 0) {
+			searchMode = SEARCH_UNCOMPRESSED;
+			a++;
+		}
+		else if (strcmp(argv[a], "-b") == 0) {
+			searchMode = SEARCH_BOTH;
+			a++;
+		}
+		else if (strcmp(argv[a], "-endo") == 0) {
+			useEndo = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-xor") == 0) {
+			useFilter = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-c") == 0) {
+			caseSensitive = false;
+			a++;
+		}
 		else if (strcmp(argv[a], "-range") == 0) {
 			a++;
 			range = (uint64_t)getInt("range", argv[a]);
 			a++;
 		}
+		else if (strcmp(argv[a], "-cp") == 0) {
+			a++;
+			checkpointFile = string(argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-cpi") == 0) {
+			a++;
+			checkpointInterval = getInt("checkpointInterval", argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-resume") == 0) {
+			a++;
+			checkpointFile = string(argv[a]);
+			resume = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-chunk") == 0) {
+			a++;
+			chunkBits = getInt("chunk", argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-chunkmap") == 0) {
+			a++;
+			chunkMapFile = string(argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-chunkretake") == 0) {
+			chunkRetake = true;
+			a++;
+		}
+		else if (strcmp(argv[a], "-coordinator") == 0) {
+			a++;
+			string c = string(argv[a]);
+			size_t sep = c.rfind(':');
+			if (sep != string::npos) {
+				coordinatorBind = c.substr(0, sep);
+				c = c.substr(sep + 1);
+			}
+			coordinatorPort = getInt("coordinator", (char*)c.c_str());
+			a++;
+		}
+		else if (strcmp(argv[a], "-token") == 0) {
+			a++;
+			token = string(argv[a]);
+			a++;
+		}
+		else if (strcmp(argv[a], "-worker") == 0) {
+			a++;
+			string w = string(argv[a]);
+			size_t sep = w.rfind(':');
+			if (sep == string::npos || sep == 0) {
+				fprintf(stderr, "[ERROR] Invalid -worker argument, host:port expected\n");
+				exit(-1);
+			}
+			workerHost = w.substr(0, sep);
+			workerPort = getInt("worker", (char*)w.substr(sep + 1).c_str());
+			a++;
+		}
+		else if (strcmp(argv[a], "-lease") == 0) {
+			a++;
+			leaseTime = getInt("lease", argv[a]);
+			a++;
+		}
 		else if (strcmp(argv[a], "-m") == 0) {
 			a++;
 			maxFound = getInt("maxFound", argv[a]);
@@ -623,6 +822,24 @@ int main(int argc, char* argv[]) {
 	}
 
 	fprintf(stdout, "VanitySearch-Bitcrack v" RELEASE "\n");
+	fprintf(stdout, "[cpu]  features=%s\n", CPUFeatures::GetFeatures().c_str());
+	fprintf(stdout, "[cpu]  kernels=%s\n", CPUFeatures::GetKernels().c_str());
+
+	if (!gpuEnable) {
+		gpuId.clear();
+		if (!tSpecified)
+			nbCPUThread = Timer::getCoreNumber();
+	}
+
+	if (nbCPUThread < 0 || (gpuId.size() == 0 && nbCPUThread == 0)) {
+		fprintf(stderr, "[ERROR] Invalid -t argument, at least one CPU thread is needed without GPU\n");
+		exit(-1);
+	}
+
+	if (gpuId.size() > 0 && searchMode != SEARCH_COMPRESSED) {
+		fprintf(stderr, "[ERROR] The GPU kernel searches compressed addresses only, use -nogpu with -u or -b\n");
+		exit(-1);
+	}
 
 	if (gridSize.size() == 0) {
 		for (int i = 0; i < gpuId.size(); i++) {
@@ -638,7 +855,8 @@ int main(int argc, char* argv[]) {
 	
 	size_t commaPos = gpuParsed.find(',');
 	std::string firstValue = gpuParsed.substr(0, commaPos);
-	gpuId[0] = std::stoi(firstValue);
+	if (gpuId.size() > 0)
+		gpuId[0] = std::stoi(firstValue);
 
 	if (range > 255)
 		range = 255;
@@ -652,33 +870,163 @@ int main(int argc, char* argv[]) {
 	Range.SubOne();
 
 	getKeySpace(string(start + ":+" + Range.GetBase16()), bc, maxKey);
+
+	if (chunkBits != 0 && (chunkBits < 1 || chunkBits > range)) {
+		fprintf(stderr, "[ERROR] Invalid -chunk argument, 1 to %d expected\n", range);
+		exit(-1);
+	}
+
+	if ((chunkBits != 0 || workerHost.length() > 0) && checkpointFile.length() > 0) {
+		fprintf(stderr, "[ERROR] -chunk and -worker keep their progress in the chunk map, -cp and -resume cannot be used\n");
+		exit(-1);
+	}
+
+	if (coordinatorPort != 0 && (chunkBits == 0 || leaseTime <= 0)) {
+		fprintf(stderr, "[ERROR] -coordinator needs -chunk and a positive -lease\n");
+		exit(-1);
+	}
+
+	if (watchInput && inputFile.length() == 0) {
+		fprintf(stderr, "[ERROR] -watch needs an input file (-i)\n");
+		exit(-1);
+	}
+
+	TargetDB db;
+	if (dbFile.length() > 0) {
+		if (address.size() > 0) {
+			fprintf(stderr, "[ERROR] -db cannot be used with -i or an address\n");
+			exit(-1);
+		}
+		if (!db.Open(dbFile))
+			exit(-1);
+	}
+
+	// Checkpoint, the range comes from the file when resuming
+	CHECKPOINT cp;
+	CHECKPOINT* resumeState = NULL;
+	string targetDigest = "";
+	if (checkpointFile.length() > 0 || workerHost.length() > 0)
+		targetDigest = (dbFile.length() > 0) ? db.GetDigest() : Checkpoint::TargetDigest(address);
+
+	if (resume) {
+		if (!Checkpoint::Load(checkpointFile, cp))
+			exit(-1);
+		if (cp.targetDigest != targetDigest) {
+			fprintf(stderr, "[ERROR] Checkpoint %s was made for another target set (%u targets)\n", checkpointFile.c_str(), cp.nbTarget);
+			exit(-1);
+		}
+		bc->ksStart.Set(&cp.ksStart);
+		bc->ksFinish.Set(&cp.ksFinish);
+		resumeState = &cp;
+	}
+
 	bc->ksNext.Set(&bc->ksStart);
 	checkKeySpace(bc, maxKey);
 
+	if (coordinatorPort != 0) {
+
+		// The coordinator owns the chunk map, chunks leased by a previous
+		// coordinator run are free again
+		ChunkMap chunks;
+		if (!chunks.Open(chunkMapFile, bc->ksStart, bc->ksFinish, chunkBits, false))
+			exit(-1);
+		uint64_t released = chunks.ReleaseClaims();
+		if (released > 0)
+			printf("[coordinator] %llu unfinished chunks released\n", (unsigned long long)released);
+		Coordinator c(coordinatorBind, coordinatorPort, &chunks, leaseTime, outputFile, token);
+		c.Run();
+		chunks.Close();
+		stopMonitorKey = true;
+		if (inputThread.joinable())
+			inputThread.join();
+		return 0;
+
+	}
+
 
 	{
 
-		fprintf(stdout, "[keyspace]  range=2^%d\n", range);
+		if (resume)
+			fprintf(stdout, "[keyspace]  resumed from %s\n", checkpointFile.c_str());
+		else
+			fprintf(stdout, "[keyspace]  range=2^%d\n", range);
 		fprintf(stdout, "[keyspace]  start=%s\n", bc->ksStart.GetBase16().c_str());
 		fprintf(stdout, "[keyspace]    end=%s\n", bc->ksFinish.GetBase16().c_str());
 		fflush(stdout);
 
 
-		idxcount = 0;
-		t_Paused = 0;
+		t_Paused = resume ? cp.elapsed : 0;
 		Pause = false;
-	repeatP:
 		Paused = false;
-		VanitySearch* v = new VanitySearch(secp, address, searchMode, stop, outputFile, maxFound, bc, batchSize);
-		v->Search(gpuId, gridSize);
-
-		while (Paused) {
-			Timer::SleepMillis(100);
-			if (!Pause) {
-				fprintf(stdout, "\nResuming...\n");
-				goto repeatP;
-				
+		VanitySearch* v = new VanitySearch(secp, address, searchMode, stop, outputFile, maxFound, bc, batchSize,
+			(dbFile.length() > 0) ? &db : NULL, caseSensitive);
+		if (checkpointFile.length() > 0)
+			v->SetCheckpoint(checkpointFile, checkpointInterval, targetDigest, resumeState);
+		v->SetEndomorphism(useEndo);
+		v->SetFilter(useFilter);
+		if (inputFile.length() > 0)
+			v->SetInputFile(inputFile, watchInput);
+
+		if (workerHost.length() > 0) {
+
+			// Each lease is a new range for the same VanitySearch
+			WorkClient client(workerHost, workerPort, targetDigest, token);
+			v->SetWorkClient(&client);
+
+			uint64_t chunk;
+			bool ok = true;
+			while (ok && client.Lease(chunk, bc->ksStart, bc->ksFinish)) {
+				bc->ksNext.Set(&bc->ksStart);
+				fprintf(stdout, "\n[worker]  chunk #%llu start=%s end=%s\n", (unsigned long long)chunk,
+					bc->ksStart.GetBase16().c_str(), bc->ksFinish.GetBase16().c_str());
+				fflush(stdout);
+				t_Paused = 0;
+				ok = v->Search(nbCPUThread, gpuId, gridSize);
+				if (ok)
+					client.Done(chunk);
+			}
+
+			fprintf(stdout, "[worker]  no more work from %s:%d\n", workerHost.c_str(), workerPort);
+			v->SetWorkClient(NULL);
+
+		} else if (chunkBits == 0) {
+
+			v->Search(nbCPUThread, gpuId, gridSize);
+
+		} else {
+
+			// Random chunks, the same VanitySearch (and lookup tables) is used for every chunk
+			ChunkMap chunks;
+			Int rangeStart(&bc->ksStart);
+			Int rangeEnd(&bc->ksFinish);
+			if (!chunks.Open(chunkMapFile, rangeStart, rangeEnd, chunkBits, chunkRetake))
+				exit(-1);
+
+			fprintf(stdout, "[chunk]  map=%s chunks=%llu done=%llu unfinished=%llu\n", chunkMapFile.c_str(),
+				(unsigned long long)chunks.GetNbChunk(), (unsigned long long)chunks.GetNbDone(),
+				(unsigned long long)chunks.GetNbClaimed());
+
+			uint64_t chunk;
+			bool ok = true;
+			while (ok && chunks.Next(chunk)) {
+				chunks.GetRange(chunk, bc->ksStart, bc->ksFinish);
+				bc->ksNext.Set(&bc->ksStart);
+				fprintf(stdout, "\n[chunk]  #%llu start=%s end=%s\n", (unsigned long long)chunk,
+					bc->ksStart.GetBase16().c_str(), bc->ksFinish.GetBase16().c_str());
+				fflush(stdout);
+				t_Paused = 0;
+				ok = v->Search(nbCPUThread, gpuId, gridSize);
+				if (ok) {
+					chunks.Done(chunk);
+					fprintf(stdout, "[chunk]  #%llu done (%llu/%llu)\n", (unsigned long long)chunk,
+						(unsigned long long)chunks.GetNbDone(), (unsigned long long)chunks.GetNbChunk());
+				}
 			}
+
+			if (ok)
+				fprintf(stdout, "[chunk]  no chunk left in %s\n", chunkMapFile.c_str());
+			chunks.Close();
+
 		}
 	}
 